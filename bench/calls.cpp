@@ -0,0 +1,50 @@
+// 过程调用吞吐量基准：分别用树遍历求值器与字节码虚拟机计算 (fib n)，
+// 输出每秒完成的 Lisp 过程调用次数。
+// 用法：mini_lisp_bench [n]
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/eval_env.h"
+#include "../src/parse.h"
+#include "../src/tokenizer.h"
+#include "../src/value.h"
+
+static ValuePtr run(EvalEnv& env, const std::string& input) {
+    std::istringstream stream(input);
+    Tokenizer tokenizer(stream);
+    Parser parser(tokenizer);
+    return env.eval(parser.parse());
+}
+
+// (fib n) 的调用次数为 2 * fib(n + 1) - 1
+static double countCalls(int n) {
+    double a = 0, b = 1;
+    for (int i = 0; i < n + 1; ++i) {
+        double next = a + b;
+        a = b;
+        b = next;
+    }
+    return 2 * a - 1;
+}
+
+static void bench(const char* name, EvalEngine engine, int n) {
+    auto env = EvalEnv::createGlobal(engine);
+    run(*env,
+        "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    auto start = std::chrono::steady_clock::now();
+    auto result = run(*env, "(fib " + std::to_string(n) + ")");
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": (fib " << n << ") = " << result->toString()
+              << ", " << seconds << " s, "
+              << static_cast<long long>(countCalls(n) / seconds)
+              << " calls/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? std::stoi(argv[1]) : 25;
+    bench("tree", EvalEngine::TREE, n);
+    bench("vm  ", EvalEngine::BYTECODE, n);
+}
@@ -0,0 +1,110 @@
+#include "analyzer.h"
+
+#include "error.h"
+#include "forms.h"
+
+static const Symbol DEFINE = SymbolValue::intern("define").get();
+static const Symbol BEGIN = SymbolValue::intern("begin").get();
+
+NodePtr Analyzer::analyze(const ValuePtr& expr) {
+    if (expr->isSelfEvaluating() || expr->isProcedure()) {
+        return std::make_shared<ConstantNode>(expr);
+    } else if (expr->isNil()) {
+        throw LispError("Evaluating nil is prohibited.");
+    } else if (auto name = expr->asSymbol()) {
+        // 由内向外查找局部变量，找不到时视为全局变量
+        std::size_t depth = 0;
+        for (auto s = scope.get(); s; s = s->parent.get(), ++depth) {
+            for (std::size_t i = 0; i < s->names.size(); ++i) {
+                if (s->names[i] == name) {
+                    return std::make_shared<LocalVariableNode>(name, depth, i);
+                }
+            }
+        }
+        return std::make_shared<GlobalVariableNode>(name);
+    }
+    auto& form = static_cast<const PairValue&>(*expr);
+    auto args = form.getRight()->toVector();
+    if (auto name = form.getLeft()->asSymbol()) {
+        auto it = SPECIAL_FORMS.find(name);
+        if (it != SPECIAL_FORMS.end()) {
+            return it->second(args, *this);
+        }
+    }
+    // 处理非特殊形式的列表表达式
+    NodePtr proc = analyze(form.getLeft());
+    return std::make_shared<CallNode>(
+        proc, analyzeSequence(args.begin(), args.end()));
+}
+
+std::vector<NodePtr> Analyzer::analyzeSequence(
+    std::vector<ValuePtr>::const_iterator begin,
+    std::vector<ValuePtr>::const_iterator end) {
+    std::vector<NodePtr> result;
+    result.reserve(end - begin);
+    for (auto it = begin; it != end; ++it) {
+        result.push_back(analyze(*it));
+    }
+    return result;
+}
+
+std::vector<Symbol> Analyzer::analyzeParams(const ValuePtr& params) {
+    std::vector<Symbol> result;
+    for (const auto& param : params->toVector()) {
+        if (auto symbol = param->asSymbol()) {
+            result.push_back(symbol);
+        } else {
+            throw LispError("Lambda parameters must be symbols.");
+        }
+    }
+    return result;
+}
+
+// 预先为体内（包括 begin 中）的内部定义分配槽位，使互相引用的定义能被解析
+void Analyzer::collectDefines(std::vector<ValuePtr>::const_iterator begin,
+                              std::vector<ValuePtr>::const_iterator end) {
+    for (auto it = begin; it != end; ++it) {
+        if (!(*it)->isPair()) continue;
+        auto& form = static_cast<const PairValue&>(**it);
+        auto head = form.getLeft()->asSymbol();
+        const auto& rest = form.getRight();
+        if (head == BEGIN) {
+            auto body = rest->toVector();
+            collectDefines(body.begin(), body.end());
+        } else if (head == DEFINE && rest->isPair()) {
+            auto target = static_cast<const PairValue&>(*rest).getLeft();
+            if (target->isPair()) {
+                target = static_cast<PairValue&>(*target).getLeft();
+            }
+            if (auto name = target->asSymbol()) declare(name);
+        }
+    }
+}
+
+std::vector<NodePtr> Analyzer::analyzeBody(
+    const std::vector<Symbol>& params,
+    std::vector<ValuePtr>::const_iterator begin,
+    std::vector<ValuePtr>::const_iterator end, std::size_t& frameSize) {
+    auto outer = scope;
+    scope = std::make_shared<Scope>(Scope{params, outer});
+    try {
+        collectDefines(begin, end);
+        auto body = analyzeSequence(begin, end);
+        frameSize = scope->names.size();
+        scope = outer;
+        return body;
+    } catch (...) {
+        scope = outer;
+        throw;
+    }
+}
+
+std::size_t Analyzer::declare(Symbol name) {
+    if (!scope) return 0;
+    auto& names = scope->names;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) return i;
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
@@ -0,0 +1,41 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include <memory>
+#include <vector>
+
+#include "node.h"
+#include "value.h"
+
+// 分析期的词法作用域，对应运行时的一个局部帧
+struct Scope {
+    std::vector<Symbol> names;  // 下标即槽位序号
+    std::shared_ptr<Scope> parent;
+};
+
+// 把解析得到的 Value 转换为可执行的节点树，并把局部变量解析为 (深度, 序号)
+class Analyzer {
+    std::shared_ptr<Scope> scope;  // 当前作用域，顶层为空
+
+    void collectDefines(std::vector<ValuePtr>::const_iterator begin,
+                        std::vector<ValuePtr>::const_iterator end);
+
+public:
+    NodePtr analyze(const ValuePtr& expr);
+    std::vector<NodePtr> analyzeSequence(
+        std::vector<ValuePtr>::const_iterator begin,
+        std::vector<ValuePtr>::const_iterator end);
+    std::vector<Symbol> analyzeParams(const ValuePtr& params);
+    // 在以 params 开头的新作用域中分析函数体或 let 体，frameSize 返回帧大小
+    std::vector<NodePtr> analyzeBody(
+        const std::vector<Symbol>& params,
+        std::vector<ValuePtr>::const_iterator begin,
+        std::vector<ValuePtr>::const_iterator end, std::size_t& frameSize);
+    // 在当前作用域中声明 name 并返回其槽位；顶层不分配槽位
+    std::size_t declare(Symbol name);
+    bool isTopLevel() const {
+        return !scope;
+    }
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "bigint.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+BigInt::BigInt(std::int64_t value) : negative(value < 0) {
+    // 先转成无符号数，避免对 INT64_MIN 取负溢出
+    std::uint64_t magnitude = negative ? 0 - static_cast<std::uint64_t>(value)
+                                       : static_cast<std::uint64_t>(value);
+    while (magnitude != 0) {
+        limbs.push_back(static_cast<std::uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInt BigInt::parse(const std::string& text) {
+    BigInt result;
+    std::size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        negative = text[pos] == '-';
+        ++pos;
+    }
+    if (pos == text.size()) {
+        throw std::invalid_argument("Invalid integer literal: " + text);
+    }
+    for (; pos < text.size(); ++pos) {
+        if (text[pos] < '0' || text[pos] > '9') {
+            throw std::invalid_argument("Invalid integer literal: " + text);
+        }
+        result.multiplyAdd(10, text[pos] - '0');
+    }
+    result.negative = negative && !result.isZero();
+    return result;
+}
+
+void BigInt::trim() {
+    while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    if (limbs.empty()) negative = false;
+}
+
+int BigInt::compareMagnitude(const BigInt& a, const BigInt& b) {
+    if (a.limbs.size() != b.limbs.size()) {
+        return a.limbs.size() < b.limbs.size() ? -1 : 1;
+    }
+    for (std::size_t i = a.limbs.size(); i-- > 0;) {
+        if (a.limbs[i] != b.limbs[i]) return a.limbs[i] < b.limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BigInt BigInt::addMagnitude(const BigInt& a, const BigInt& b) {
+    BigInt result;
+    std::size_t size = std::max(a.limbs.size(), b.limbs.size());
+    result.limbs.resize(size + 1);
+    std::uint64_t carry = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        std::uint64_t sum = carry;
+        if (i < a.limbs.size()) sum += a.limbs[i];
+        if (i < b.limbs.size()) sum += b.limbs[i];
+        result.limbs[i] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    result.limbs[size] = static_cast<std::uint32_t>(carry);
+    result.trim();
+    return result;
+}
+
+// 要求 |a| >= |b|
+BigInt BigInt::subtractMagnitude(const BigInt& a, const BigInt& b) {
+    BigInt result;
+    result.limbs.resize(a.limbs.size());
+    std::int64_t borrow = 0;
+    for (std::size_t i = 0; i < a.limbs.size(); ++i) {
+        std::int64_t diff = static_cast<std::int64_t>(a.limbs[i]) - borrow;
+        if (i < b.limbs.size()) diff -= b.limbs[i];
+        borrow = diff < 0;
+        if (diff < 0) diff += std::int64_t{1} << 32;
+        result.limbs[i] = static_cast<std::uint32_t>(diff);
+    }
+    result.trim();
+    return result;
+}
+
+void BigInt::multiplyAdd(std::uint32_t m, std::uint32_t a) {
+    std::uint64_t carry = a;
+    for (auto& limb : limbs) {
+        std::uint64_t product = static_cast<std::uint64_t>(limb) * m + carry;
+        limb = static_cast<std::uint32_t>(product);
+        carry = product >> 32;
+    }
+    if (carry != 0) limbs.push_back(static_cast<std::uint32_t>(carry));
+}
+
+std::uint32_t BigInt::divideSmall(std::uint32_t d) {
+    std::uint64_t remainder = 0;
+    for (std::size_t i = limbs.size(); i-- > 0;) {
+        std::uint64_t current = (remainder << 32) | limbs[i];
+        limbs[i] = static_cast<std::uint32_t>(current / d);
+        remainder = current % d;
+    }
+    trim();
+    return static_cast<std::uint32_t>(remainder);
+}
+
+bool BigInt::fitsInt64() const {
+    if (limbs.size() < 2) return true;
+    if (limbs.size() > 2) return false;
+    std::uint64_t magnitude =
+        (static_cast<std::uint64_t>(limbs[1]) << 32) | limbs[0];
+    return magnitude < (std::uint64_t{1} << 63) ||
+           (negative && magnitude == (std::uint64_t{1} << 63));
+}
+
+std::int64_t BigInt::toInt64() const {
+    std::uint64_t magnitude = 0;
+    for (std::size_t i = limbs.size(); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs[i];
+    }
+    return negative ? static_cast<std::int64_t>(0 - magnitude)
+                    : static_cast<std::int64_t>(magnitude);
+}
+
+double BigInt::toDouble() const {
+    double result = 0;
+    for (std::size_t i = limbs.size(); i-- > 0;) {
+        result = result * 4294967296.0 + limbs[i];
+    }
+    return negative ? -result : result;
+}
+
+std::string BigInt::toString() const {
+    if (isZero()) return "0";
+    BigInt magnitude = *this;
+    std::string digits;
+    while (!magnitude.isZero()) {
+        // 每次取出 9 位十进制数字
+        auto chunk = magnitude.divideSmall(1000000000);
+        for (int i = 0; i < 9; ++i) {
+            digits += static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+            if (magnitude.isZero() && chunk == 0) break;
+        }
+    }
+    if (negative) digits += '-';
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+std::size_t BigInt::hash() const {
+    std::size_t result = negative;
+    for (auto limb : limbs) result = result * 1000003 ^ limb;
+    return result;
+}
+
+BigInt BigInt::operator-() const {
+    BigInt result = *this;
+    if (!result.isZero()) result.negative = !negative;
+    return result;
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) {
+    if (a.negative == b.negative) {
+        BigInt result = BigInt::addMagnitude(a, b);
+        result.negative = a.negative && !result.isZero();
+        return result;
+    }
+    // 异号相加即绝对值相减，结果取绝对值较大者的符号
+    if (BigInt::compareMagnitude(a, b) >= 0) {
+        BigInt result = BigInt::subtractMagnitude(a, b);
+        result.negative = a.negative && !result.isZero();
+        return result;
+    }
+    BigInt result = BigInt::subtractMagnitude(b, a);
+    result.negative = b.negative && !result.isZero();
+    return result;
+}
+
+BigInt operator-(const BigInt& a, const BigInt& b) {
+    return a + -b;
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+    BigInt result;
+    if (a.isZero() || b.isZero()) return result;
+    result.limbs.assign(a.limbs.size() + b.limbs.size(), 0);
+    for (std::size_t i = 0; i < a.limbs.size(); ++i) {
+        std::uint64_t carry = 0;
+        for (std::size_t j = 0; j < b.limbs.size(); ++j) {
+            std::uint64_t current =
+                static_cast<std::uint64_t>(a.limbs[i]) * b.limbs[j] +
+                result.limbs[i + j] + carry;
+            result.limbs[i + j] = static_cast<std::uint32_t>(current);
+            carry = current >> 32;
+        }
+        result.limbs[i + b.limbs.size()] = static_cast<std::uint32_t>(carry);
+    }
+    result.negative = a.negative != b.negative;
+    result.trim();
+    return result;
+}
+
+void BigInt::divide(const BigInt& a, const BigInt& b, BigInt& quotient,
+                    BigInt& remainder) {
+    if (b.isZero()) throw std::domain_error("Division by zero.");
+    if (compareMagnitude(a, b) < 0) {
+        quotient = BigInt();
+        remainder = a;
+        return;
+    }
+    BigInt q;
+    BigInt r;
+    if (b.limbs.size() == 1) {
+        q = a;
+        q.negative = false;
+        r = BigInt(static_cast<std::int64_t>(q.divideSmall(b.limbs[0])));
+    } else {
+        // 逐位的移位相减长除法
+        q.limbs.assign(a.limbs.size(), 0);
+        BigInt divisor = b;
+        divisor.negative = false;
+        for (std::size_t bit = a.limbs.size() * 32; bit-- > 0;) {
+            std::uint32_t carry = (a.limbs[bit / 32] >> (bit % 32)) & 1;
+            for (auto& limb : r.limbs) {
+                std::uint32_t next = limb >> 31;
+                limb = (limb << 1) | carry;
+                carry = next;
+            }
+            if (carry != 0) r.limbs.push_back(carry);
+            if (compareMagnitude(r, divisor) >= 0) {
+                r = subtractMagnitude(r, divisor);
+                q.limbs[bit / 32] |= std::uint32_t{1} << (bit % 32);
+            }
+        }
+        q.trim();
+    }
+    q.negative = a.negative != b.negative && !q.isZero();
+    r.negative = a.negative && !r.isZero();
+    quotient = std::move(q);
+    remainder = std::move(r);
+}
+
+int BigInt::compare(const BigInt& a, const BigInt& b) {
+    if (a.negative != b.negative) return a.negative ? -1 : 1;
+    int result = compareMagnitude(a, b);
+    return a.negative ? -result : result;
+}
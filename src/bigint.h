@@ -0,0 +1,53 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 任意精度整数：符号加上以 2^32 为基、低位在前的绝对值
+class BigInt {
+    bool negative = false;
+    std::vector<std::uint32_t> limbs;  // 值为零时为空
+
+    void trim();
+    static int compareMagnitude(const BigInt& a, const BigInt& b);
+    static BigInt addMagnitude(const BigInt& a, const BigInt& b);
+    static BigInt subtractMagnitude(const BigInt& a, const BigInt& b);
+    // 绝对值乘以 m 再加上 a，用于十进制转换
+    void multiplyAdd(std::uint32_t m, std::uint32_t a);
+    // 绝对值除以 d，返回余数
+    std::uint32_t divideSmall(std::uint32_t d);
+
+public:
+    BigInt() = default;
+    BigInt(std::int64_t value);
+    // 解析十进制整数，可带正负号
+    static BigInt parse(const std::string& text);
+
+    bool isZero() const {
+        return limbs.empty();
+    }
+    bool isNegative() const {
+        return negative;
+    }
+    bool isOdd() const {
+        return !limbs.empty() && (limbs[0] & 1);
+    }
+    bool fitsInt64() const;
+    std::int64_t toInt64() const;
+    double toDouble() const;
+    std::string toString() const;
+    std::size_t hash() const;
+
+    BigInt operator-() const;
+    friend BigInt operator+(const BigInt& a, const BigInt& b);
+    friend BigInt operator-(const BigInt& a, const BigInt& b);
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+    // 截断除法：商向零取整，余数与被除数同号
+    static void divide(const BigInt& a, const BigInt& b, BigInt& quotient,
+                       BigInt& remainder);
+    static int compare(const BigInt& a, const BigInt& b);
+};
+
+#endif
@@ -1,543 +1,738 @@
 #include "builtins.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 
+#include "equality.h"
 #include "error.h"
 #include "eval_env.h"
+#include "gc.h"
+#include "hash_table.h"
+#include "image.h"
+#include "loader.h"
+#include "numeric.h"
+#include "pool.h"
+#include "port.h"
 #include "value.h"
 
-std::unordered_map<std::string,
-                   ValuePtr (*)(const std::vector<ValuePtr>&, EvalEnv& env)>
-    builtins = {
-        {"+", add},
-        {"print", print},
-        {"display", display},
-        {"exit", exit_b},
-        {"newline", newline},
-        {"apply", apply},
-        {"displayln", displayln},
-        {"error", error},
-        {"eval", eval},
-        //
-        {"null?", null_q},
-        {"number?", number_q},
-        {"pair?", pair_q},
-        {"car", car},
-        {"cdr", cdr},
-        {"cons", cons},
-        {"length", length},
-        {"list", list},
-        {"append", append},
-        {"map", b_map},
-        {"filter", b_filter},
-        {"reduce", b_reduce},
-        {"-", subtract},
-        {"*", multiply},
-        {"/", divide},
-        {"abs", abs_f},
-        {"expt", exp},
-        {"quotient", quotient},
-        {"modulo", modulo},
-        {"remainder", remainder},
-        {"zero?", zero_q},
-        {"atom?", atom_q},
-        {"boolean?", boolean_q},
-        {"integer?", integer_q},
-        {"list?", list_q},
-        {"procedure?", procedure_q},
-        {"string?", string_q},
-        {"symbol?", symbol_q},  //
-        {"eq?", eq},
-        {"equal?", equal},
-        {"<", less},
-        {">", greater},
-        {"<=", less_equal},
-        {">=", greater_equal},
-        {"even?", even},
-        {"odd?", odd},
-        {"not", b_not},
-        {"=", equal_sym},
-        // 添加其他内置过程
+const std::unordered_map<std::string, BuiltinInfo> builtins = {
+    {"+", {add, 0, VARIADIC}},
+    {"print", {print, 0, VARIADIC}},
+    {"display", {display, 1, 2}},
+    {"exit", {exit_b, 0, 1}},
+    {"newline", {newline, 0, 1}},
+    {"apply", {apply, 2, 2}},
+    {"displayln", {displayln, 1, 2}},
+    {"error", {error, 1, VARIADIC}},
+    {"eval", {eval, 1, 1}},
+    {"load", {load, 1, 1}},
+    {"write-fasl", {write_fasl, 2, 2}},
+    {"read-fasl", {read_fasl, 1, 1}},
+    {"flush-output", {flush_output, 0, 1}},
+    {"open-output-string", {open_output_string, 0, 0}},
+    {"get-output-string", {get_output_string, 1, 1}},
+    {"collect-garbage", {collect_garbage, 0, 0}},
+    //
+    {"null?", {null_q, 1, 1}},
+    {"number?", {number_q, 1, 1}},
+    {"pair?", {pair_q, 1, 1}},
+    {"car", {car, 1, 1}},
+    {"cdr", {cdr, 1, 1}},
+    {"cons", {cons, 2, 2}},
+    {"length", {length, 1, 1}},
+    {"list", {list, 0, VARIADIC}},
+    {"append", {append, 0, VARIADIC}},
+    {"map", {b_map, 2, 2}},
+    {"filter", {b_filter, 2, 2}},
+    {"reduce", {b_reduce, 2, 2}},
+    {"-", {subtract, 1, VARIADIC}},
+    {"*", {multiply, 0, VARIADIC}},
+    {"/", {divide, 1, VARIADIC}},
+    {"abs", {abs_f, 1, 1}},
+    {"expt", {exp, 2, 2}},
+    {"quotient", {quotient, 2, 2}},
+    {"modulo", {modulo, 2, 2}},
+    {"remainder", {remainder, 2, 2}},
+    {"zero?", {zero_q, 1, 1}},
+    {"atom?", {atom_q, 1, 1}},
+    {"boolean?", {boolean_q, 1, 1}},
+    {"integer?", {integer_q, 1, 1}},
+    {"list?", {list_q, 1, 1}},
+    {"procedure?", {procedure_q, 1, 1}},
+    {"string?", {string_q, 1, 1}},
+    {"symbol?", {symbol_q, 1, 1}},  //
+    {"eq?", {eq, 2, 2}},
+    {"eqv?", {eqv, 2, 2}},
+    {"equal?", {equal, 2, 2}},
+    {"<", {less, 2, 2}},
+    {">", {greater, 2, 2}},
+    {"<=", {less_equal, 2, 2}},
+    {">=", {greater_equal, 2, 2}},
+    {"even?", {even, 1, 1}},
+    {"odd?", {odd, 1, 1}},
+    {"not", {b_not, 1, 1}},
+    {"=", {equal_sym, 2, 2}},
+    //
+    {"make-hash-table", {make_hash_table, 0, 1}},
+    {"hash-table?", {hash_table_q, 1, 1}},
+    {"hash-ref", {hash_ref, 2, 3}},
+    {"hash-set!", {hash_set, 3, 3}},
+    {"hash-remove!", {hash_remove, 2, 2}},
+    {"hash-has-key?", {hash_has_key, 2, 2}},
+    {"hash-count", {hash_count, 1, 1}},
+    {"hash-keys", {hash_keys, 1, 1}},
+    {"hash-values", {hash_values, 1, 1}},
+    {"hash->list", {hash_to_list, 1, 1}},
+    {"hash-for-each", {hash_for_each, 2, 2}},
+    {"hash-clear!", {hash_clear, 1, 1}},
+    //
+    {"make-vector", {make_vector, 1, 2}},
+    {"vector", {vector, 0, VARIADIC}},
+    {"vector?", {vector_q, 1, 1}},
+    {"vector-ref", {vector_ref, 2, 2}},
+    {"vector-set!", {vector_set, 3, 3}},
+    {"vector-length", {vector_length, 1, 1}},
+    {"vector->list", {vector_to_list, 1, 1}},
+    {"list->vector", {list_to_vector, 1, 1}},
+    {"vector-map", {vector_map, 2, 2}},
+    {"vector-fill!", {vector_fill, 2, 2}},
+    // 添加其他内置过程
 };
 
 // 类型检查库
 
-ValuePtr null_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("null? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isNil());
+ValuePtr null_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isNil());
 }
 
-ValuePtr number_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("number? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isNumber());
+ValuePtr number_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isNumber());
 }
 
-ValuePtr pair_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("pair? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isPair());
+ValuePtr pair_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isPair());
 }
 
-ValuePtr atom_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("atom? expects 1 argument.");
+ValuePtr atom_q(std::span<const ValuePtr> params, EvalEnv& env) {
     auto& param = params.front();
-    return std::make_shared<BooleanValue>(
-        param->isBoolean() || param->isNumber() || param->isString() ||
-        param->isSymbol() || param->isNil());
+    return BooleanValue::of(param->isBoolean() || param->isNumber() ||
+                            param->isString() || param->isSymbol() ||
+                            param->isNil());
 }
 
-ValuePtr boolean_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("boolean? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isBoolean());
+ValuePtr boolean_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isBoolean());
 }
 
-ValuePtr integer_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("integer? expects 1 argument.");
+ValuePtr integer_q(std::span<const ValuePtr> params, EvalEnv& env) {
     auto& param = params.front();
-    return std::make_shared<BooleanValue>(param->isNumber() &&
-                                          param->asNumber() ==
-                                              std::floor(param->asNumber()));
+    if (param->isExact()) return BooleanValue::of(true);
+    return BooleanValue::of(param->isNumber() &&
+                            param->asNumber() == std::floor(param->asNumber()));
 }
 
-ValuePtr list_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("list? expects 1 argument.");
+ValuePtr list_q(std::span<const ValuePtr> params, EvalEnv& env) {
     auto& param = params.front();
-    if (param->isNil()) return std::make_shared<BooleanValue>(true);
-    if (!param->isPair()) return std::make_shared<BooleanValue>(false);
+    if (param->isNil()) return BooleanValue::of(true);
+    if (!param->isPair()) return BooleanValue::of(false);
     auto current = param;
     while (current->isPair()) {
-        auto pair = std::dynamic_pointer_cast<PairValue>(current);
-        current = pair->getRight();
+        current = static_cast<PairValue&>(*current).getRight();
     }
-    return std::make_shared<BooleanValue>(current->isNil());
+    return BooleanValue::of(current->isNil());
 }
 
-ValuePtr procedure_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("procedure? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isProcedure());
+ValuePtr procedure_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isProcedure());
 }
 
-ValuePtr string_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("string? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isString());
+ValuePtr string_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isString());
 }
 
-ValuePtr symbol_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("symbol? expects 1 argument.");
-    return std::make_shared<BooleanValue>(params.front()->isSymbol());
+ValuePtr symbol_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->isSymbol());
 }
 
 // 对子与列表操作库
 
-ValuePtr car(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty() || !params.front()->isPair()) {
+ValuePtr car(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params.front()->isPair()) {
         throw LispError("car expects a non-empty list.");
     }
-    auto pair = std::dynamic_pointer_cast<PairValue>(params.front());
-    return pair->getLeft();
+    return static_cast<PairValue&>(*params.front()).getLeft();
 }
 
-ValuePtr cdr(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty() || !params.front()->isPair()) {
+ValuePtr cdr(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params.front()->isPair()) {
         throw LispError("cdr expects a non-empty list.");
     }
-    auto pair = std::dynamic_pointer_cast<PairValue>(params.front());
-    return pair->getRight();
+    return static_cast<PairValue&>(*params.front()).getRight();
 }
 
-ValuePtr cons(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("cons expects 2 arguments.");
-    }
-    return std::make_shared<PairValue>(params[0], params[1]);
+ValuePtr cons(std::span<const ValuePtr> params, EvalEnv& env) {
+    return makePooled<PairValue>(params[0], params[1]);
 }
 
-ValuePtr length(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.front()->isNil() && params.size() == 1) {
-        return std::make_shared<NumericValue>(0);
+ValuePtr length(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (params.front()->isNil()) {
+        return IntegerValue::of(0);
     }
-    if (params.empty() || !params.front()->isPair()) {
+    if (!params.front()->isPair()) {
         throw LispError("length expects a list.");
     }
     int count = 0;
     auto current = params.front();
     while (current->isPair()) {
-        auto pair = std::dynamic_pointer_cast<PairValue>(current);
-        current = pair->getRight();
+        current = static_cast<PairValue&>(*current).getRight();
         ++count;
     }
-    return std::make_shared<NumericValue>(count);
+    return IntegerValue::of(count);
 }
 
-ValuePtr list(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    ValuePtr result = std::make_shared<NilValue>();
+ValuePtr list(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = NilValue::instance();
     for (auto it = params.rbegin(); it != params.rend(); ++it) {
-        result = std::make_shared<PairValue>(*it, result);
+        result = makePooled<PairValue>(*it, result);
     }
     return result;
 }
 
-ValuePtr append(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    std::vector<ValuePtr> result;  // 初始化一个空向量用于存储结果
+ValuePtr append(std::span<const ValuePtr> params, EvalEnv& env) {
+    ListBuilder result;
     for (const auto& param : params) {
         if (param->isNil())
             continue;
         else if (!param->isPair()) {
-            // 如果参数不是PairValue，直接添加到结果向量中
-            result.push_back(param);
+            // 如果参数不是PairValue，直接作为一个元素追加
+            result.push(param);
         } else {
-            // 如果参数是PairValue，将其转换为向量并合并到结果向量中
-            auto vectorFromPair = param->toVector();
-            result.insert(result.end(), vectorFromPair.begin(),
-                          vectorFromPair.end());
+            // 如果参数是PairValue，逐个追加其元素
+            for (const auto& elem : param->elements()) {
+                result.push(elem);
+            }
         }
     }
-    // 将结果向量转换为列表Value并返回
-    if (result.empty()) {
-        return std::make_shared<NilValue>();  // 如果结果为空，返回NilValue
-    }
-    return list(result, env);  // 返回构建的ListValue对象f
+    return result.build();
 }
 
-ValuePtr b_map(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) throw LispError("map expects 2 arguments.");
+ValuePtr b_map(std::span<const ValuePtr> args, EvalEnv& env) {
     auto func = args[0];
-    auto list = args[1]->toVector();
-    std::vector<ValuePtr> result;
-    for (auto& elem : list) {
-        std::vector<ValuePtr> funcArgs = {elem};
-        result.push_back(env.apply(func, funcArgs));
+    ListBuilder result;
+    auto it = args[1]->elements().begin();
+    for (; it != std::default_sentinel; ++it) {
+        const ValuePtr& element = *it;
+        result.push(env.apply(func, std::span(&element, 1)));
     }
-    return std::make_shared<ListValue>(result);
+    if (!it.position()->isNil()) throw LispError("map expects a list.");
+    return result.build();
 }
 
-ValuePtr b_filter(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) throw LispError("filter expects 2 arguments.");
+ValuePtr b_filter(std::span<const ValuePtr> args, EvalEnv& env) {
     auto pred = args[0];
-    auto list = args[1]->toVector();
-    std::vector<ValuePtr> result;
-    for (auto& elem : list) {
-        std::vector<ValuePtr> predArgs = {elem};
-        if (env.apply(pred, predArgs)->asBoolean()) {
-            result.push_back(elem);
+    ListBuilder result;
+    auto it = args[1]->elements().begin();
+    for (; it != std::default_sentinel; ++it) {
+        const ValuePtr& element = *it;
+        if (env.apply(pred, std::span(&element, 1))->isTrue()) {
+            result.push(element);
         }
     }
-    return std::make_shared<ListValue>(result);
+    if (!it.position()->isNil()) throw LispError("filter expects a list.");
+    return result.build();
 }
 
-ValuePtr b_reduce(const std::vector<ValuePtr>& args, EvalEnv& env) {
-    if (args.size() != 2) throw LispError("reduce expects 2 arguments.");
+ValuePtr b_reduce(std::span<const ValuePtr> args, EvalEnv& env) {
     auto func = args[0];
-    auto list = args[1]->toVector();
-    ValuePtr result = list[0];
-    list.erase(list.begin());
-    for (auto& elem : list) {
-        std::vector<ValuePtr> funcArgs = {result, elem};
-        result = env.apply(func, funcArgs);
+    if (!args[1]->isPair()) {
+        throw LispError("reduce expects a non-empty list.");
+    }
+    auto it = args[1]->elements().begin();
+    ValuePtr result = *it;
+    for (++it; it != std::default_sentinel; ++it) {
+        ValuePtr pair[] = {std::move(result), *it};
+        result = env.apply(func, pair);
     }
     return result;
 }
 
 // 核心库
 
-ValuePtr apply(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) throw LispError("apply expects 2 arguments.");
+ValuePtr apply(std::span<const ValuePtr> params, EvalEnv& env) {
     auto& proc = params[0];
     auto list = params[1]->toVector();
     return env.apply(proc, list);
 }
 
-ValuePtr display(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("display expects 1 argument.");
-    if (params.front()->isString()) {
-        auto str = params.front()->toString();
-        std::cout << str.substr(1, str.length() - 2);  // 去掉字符串首尾的引号
-    } else
-        std::cout << "'" + params.front()->toString();
-    return std::make_shared<NilValue>();
+// 取出第 index 个参数指定的输出端口，省略时为标准输出
+static OutputPortValue& portArg(std::span<const ValuePtr> params,
+                                std::size_t index, const char* name) {
+    if (params.size() <= index) return *standardOutputPort();
+    if (params[index]->getType() != ValueType::OUTPUT_PORT) {
+        throw LispError(std::string(name) + " expects an output port.");
+    }
+    return static_cast<OutputPortValue&>(*params[index]);
+}
+
+ValuePtr display(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto& port = portArg(params, 1, "display");
+    auto& value = *params.front();
+    if (value.isString()) {
+        port.write(static_cast<StringValue&>(value).getValue());
+    } else {
+        port.write('\'');
+        port.print(value);
+    }
+    return NilValue::instance();
 }
 
-ValuePtr displayln(const std::vector<ValuePtr>& params, EvalEnv& env) {
+ValuePtr displayln(std::span<const ValuePtr> params, EvalEnv& env) {
     display(params, env);
-    std::cout << std::endl;
-    return std::make_shared<NilValue>();
+    portArg(params, 1, "displayln").write('\n');
+    return NilValue::instance();
 }
 
-ValuePtr error(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("error expects 1 argument.");
+ValuePtr error(std::span<const ValuePtr> params, EvalEnv& env) {
     throw LispError(params.front()->toString());
 }
 
-ValuePtr eval(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("eval expects 1 argument.");
+ValuePtr eval(std::span<const ValuePtr> params, EvalEnv& env) {
     return env.eval(params.front());
 }
 
-ValuePtr print(const std::vector<ValuePtr>& params, EvalEnv& env) {
+ValuePtr load(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[0]->isString()) {
+        throw LispError("load expects a file name string.");
+    }
+    // 脚本中的定义总是写入全局环境
+    auto& path = static_cast<StringValue&>(*params[0]).getValue();
+    return loadFile(path, env.getGlobal());
+}
+
+ValuePtr write_fasl(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[1]->isString()) {
+        throw LispError("write-fasl expects a value and a file name string.");
+    }
+    auto& path = static_cast<StringValue&>(*params[1]).getValue();
+    writeFasl(path, params[0], env.getGlobal());
+    return NilValue::instance();
+}
+
+ValuePtr read_fasl(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[0]->isString()) {
+        throw LispError("read-fasl expects a file name string.");
+    }
+    auto& path = static_cast<StringValue&>(*params[0]).getValue();
+    return readFasl(path, env.getGlobal());
+}
+
+ValuePtr print(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto& port = *standardOutputPort();
     for (const auto& param : params) {
-        std::cout << param->toString() << " ";
+        port.print(*param);
+        port.write(' ');
     }
-    std::cout << std::endl;
-    return std::make_shared<NilValue>();
+    port.write('\n');
+    return NilValue::instance();
 }
 
-ValuePtr exit_b(const std::vector<ValuePtr>& params, EvalEnv& env) {
+ValuePtr exit_b(std::span<const ValuePtr> params, EvalEnv& env) {
     int e = 0;
     if (!params.empty()) {
         e = std::stoi(params.front()->toString());
     }
+    standardOutputPort()->flush();
     std::exit(e);
 }
 
-ValuePtr newline(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    std::cout << std::endl;
-    return std::make_shared<NilValue>();
+ValuePtr newline(std::span<const ValuePtr> params, EvalEnv& env) {
+    portArg(params, 0, "newline").write('\n');
+    return NilValue::instance();
+}
+
+ValuePtr flush_output(std::span<const ValuePtr> params, EvalEnv& env) {
+    portArg(params, 0, "flush-output").flush();
+    return NilValue::instance();
+}
+
+ValuePtr open_output_string(std::span<const ValuePtr> params, EvalEnv& env) {
+    return std::make_shared<OutputPortValue>();
+}
+
+ValuePtr get_output_string(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (params[0]->getType() != ValueType::OUTPUT_PORT ||
+        !static_cast<OutputPortValue&>(*params[0]).isStringPort()) {
+        throw LispError("get-output-string expects a string output port.");
+    }
+    return std::make_shared<StringValue>(
+        static_cast<OutputPortValue&>(*params[0]).getString());
+}
+
+// 立即回收一次只被彼此引用的环境与容器，返回断开的对象个数
+ValuePtr collect_garbage(std::span<const ValuePtr> params, EvalEnv& env) {
+    return IntegerValue::of(
+        static_cast<std::int64_t>(CycleCollector::collect()));
 }
 
 // 算术运算库
-ValuePtr add(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    double result = 0;
+ValuePtr add(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = IntegerValue::of(0);
     for (const auto& i : params) {
         if (!i->isNumber()) {
             throw LispError("Cannot add a non-numeric value.");
         }
-        result += i->asNumber();
+        result = numberAdd(*result, *i);
     }
-    return std::make_shared<NumericValue>(result);
+    return result;
 }
 
-ValuePtr subtract(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) {
-        throw LispError("subtract expects at least 1 argument.");
-    }
-    double result = params.front()->asNumber();
+ValuePtr subtract(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = params.front();
     if (params.size() == 1) {  // 负号操作
-        return std::make_shared<NumericValue>(-result);
+        return numberNegate(*result);
     }
     for (auto it = params.begin() + 1; it != params.end(); ++it) {
         if (!(*it)->isNumber()) {
             throw LispError("All arguments must be numbers.");
         }
-        result -= (*it)->asNumber();
+        result = numberSubtract(*result, **it);
     }
-    return std::make_shared<NumericValue>(result);
+    return result;
 }
 
-ValuePtr multiply(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    double result = 1;
+ValuePtr multiply(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = IntegerValue::of(1);
     for (const auto& i : params) {
         if (!i->isNumber()) {
             throw LispError("Cannot multiply non-numeric values.");
         }
-        result *= i->asNumber();
+        result = numberMultiply(*result, *i);
     }
-    return std::make_shared<NumericValue>(result);
+    return result;
 }
 
-ValuePtr divide(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() < 1) {
-        throw LispError("divide expects at least 1 arguments.");
-    }
+ValuePtr divide(std::span<const ValuePtr> params, EvalEnv& env) {
     if (params.size() == 1) {
-        double d = params.front()->asNumber();
-        if (d == 0) {
-            throw LispError("Division by zero.");
-        }
-        return std::make_shared<NumericValue>(1 / d);
+        return numberDivide(*IntegerValue::of(1), *params.front());
     }
-    double result = params.front()->asNumber();
+    ValuePtr result = params.front();
     for (auto it = params.begin() + 1; it != params.end(); ++it) {
-        double d = (*it)->asNumber();
-        if (d == 0) {
-            throw LispError("Division by zero.");
-        }
-        result /= d;
+        result = numberDivide(*result, **it);
     }
-    return std::make_shared<NumericValue>(result);
+    return result;
 }
 
-ValuePtr abs_f(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty() || !params.front()->isNumber()) {
+ValuePtr abs_f(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params.front()->isNumber()) {
         throw LispError("abs expects a numeric argument.");
     }
-    return std::make_shared<NumericValue>(std::abs(params.front()->asNumber()));
+    auto& x = params.front();
+    return numberCompare(*x, *IntegerValue::of(0)) < 0 ? numberNegate(*x) : x;
 }
 
-ValuePtr exp(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2 || !params[0]->isNumber() ||
+ValuePtr exp(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[0]->isNumber() ||
         !params[1]->isNumber()) {
         throw LispError("expt expects two numeric arguments.");
     }
-    double base = params[0]->asNumber();
-    double ex = params[1]->asNumber();
-    return std::make_shared<NumericValue>(std::pow(base, ex));
+    return numberExpt(*params[0], *params[1]);
 }
 
-ValuePtr quotient(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2 || !params[0]->isNumber() ||
+ValuePtr quotient(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[0]->isNumber() ||
         !params[1]->isNumber()) {
         throw LispError("quotient expects two numeric arguments.");
     }
-    int dividend = params[0]->asNumber();
-    int d = params[1]->asNumber();
-    if (d == 0) {
-        throw LispError("Division by zero in quotient.");
-    }
-    return std::make_shared<NumericValue>(dividend / d);
+    return numberQuotient(*params[0], *params[1]);
 }
 
-ValuePtr modulo(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("modulo expects 2 arguments.");
-    }
+ValuePtr modulo(std::span<const ValuePtr> params, EvalEnv& env) {
     auto& x = params[0];
     auto& y = params[1];
     if (!x->isNumber() || !y->isNumber()) {
         throw LispError("modulo arguments must be numbers.");
     }
-    double xVal = x->asNumber();
-    double yVal = y->asNumber();
-    if (yVal == 0) {
-        throw LispError("b-modulo division by zero.");
-    }
-    double result = std::fmod(xVal, yVal);
-    if ((result < 0) != (yVal < 0)) {
-        result += yVal;
-    }
-    return std::make_shared<NumericValue>(result);
+    return numberModulo(*x, *y);
 }
 
-ValuePtr remainder(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2 || !params[0]->isNumber() ||
+ValuePtr remainder(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[0]->isNumber() ||
         !params[1]->isNumber()) {
         throw LispError("remainder expects two numeric arguments.");
     }
-    int dividend = params[0]->asNumber();
-    int d = params[1]->asNumber();
-    if (d == 0) {
-        throw LispError("Division by zero in remainder.");
-    }
-    return std::make_shared<NumericValue>(dividend % d);
+    return numberRemainder(*params[0], *params[1]);
 }
 
 // 比较库
-ValuePtr eq(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("eq? expects 2 arguments.");
-    }
-    bool result = false;
-    if (params[0]->isNumber() && params[1]->isNumber()) {
-        result = params[0]->asNumber() == params[1]->asNumber();
-    } else if (params[0]->isBoolean() && params[1]->isBoolean()) {
-        result = params[0]->asBoolean() == params[1]->asBoolean();
-    } else if (params[0]->isString() && params[1]->isString()) {
-        result = params[0]->toString() == params[1]->toString();
-    } else if (params[0]->isSymbol() && params[1]->isSymbol()) {
-        result = params[0]->toString() == params[1]->toString();
-    } else if (params[0]->isNil() && params[1]->isNil()) {
-        result = true;
-    } else if (params[0]->isPair() && params[1]->isPair()) {
-        result = params[0] == params[1];
-    } else if (params[0]->isProcedure() && params[1]->isProcedure()) {
-        result = params[0] == params[1];
-    }
-    return std::make_shared<BooleanValue>(result);
-}
-
-ValuePtr b_not(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty()) throw LispError("not expects 1 argument.");
+ValuePtr eq(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(isEq(params[0], params[1]));
+}
+
+ValuePtr eqv(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(isEqv(params[0], params[1]));
+}
+
+ValuePtr b_not(std::span<const ValuePtr> params, EvalEnv& env) {
     auto& param = params.front();
 
     bool result = param->isBoolean();
     if (result) {
         result = !param->asBoolean();
     }
-    return std::make_shared<BooleanValue>(result);
+    return BooleanValue::of(result);
 }
 
-ValuePtr equal_sym(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) throw LispError("equal? expects 2 arguments.");
-    return std::make_shared<BooleanValue>(params[0]->toString() ==
-                                          params[1]->toString());
+ValuePtr equal_sym(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params[0]->isNumber() || !params[1]->isNumber()) {
+        throw LispError("= expects numeric arguments.");
+    }
+    return BooleanValue::of(numberCompare(*params[0], *params[1]) == 0);
 }
 
-ValuePtr zero_q(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty() || !params.front()->isNumber()) {
+ValuePtr zero_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params.front()->isNumber()) {
         throw LispError("zero? expects a numeric argument.");
     }
-    return std::make_shared<BooleanValue>(params.front()->asNumber() == 0);
+    return BooleanValue::of(numberIsZero(*params.front()));
 }
 
-ValuePtr equal(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("= expects 2 arguments.");
-    }
-    bool result = false;
-    if (params[0]->isNumber() && params[1]->isNumber()) {
-        result = params[0]->asNumber() == params[1]->asNumber();
-    } else if (params[0]->isBoolean() && params[1]->isBoolean()) {
-        result = params[0]->asBoolean() == params[1]->asBoolean();
-    } else if (params[0]->isString() && params[1]->isString() ||
-               params[0]->isPair() && params[1]->isPair() ||
-               params[0]->isProcedure() && params[1]->isProcedure()) {
-        result = params[0]->toString() == params[1]->toString();
-    } else if (params[0]->isSymbol() && params[1]->isSymbol()) {
-        result = params[0]->toString() == params[1]->toString();
-    } else if (params[0]->isNil() && params[1]->isNil()) {
-        result = true;
-    }
-    return std::make_shared<BooleanValue>(result);
+ValuePtr equal(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(isEqual(params[0], params[1]));
 }
 
-ValuePtr less(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("< expects 2 arguments.");
-    }
-    return std::make_shared<BooleanValue>(params[0]->asNumber() <
-                                          params[1]->asNumber());
+ValuePtr less(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(numberCompare(*params[0], *params[1]) < 0);
 }
 
-ValuePtr greater(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("> expects 2 arguments.");
-    }
-    return std::make_shared<BooleanValue>(params[0]->asNumber() >
-                                          params[1]->asNumber());
+ValuePtr greater(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(numberCompare(*params[0], *params[1]) > 0);
 }
 
-ValuePtr less_equal(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError("<= expects 2 arguments.");
-    }
-    return std::make_shared<BooleanValue>(params[0]->asNumber() <=
-                                          params[1]->asNumber());
+ValuePtr less_equal(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(numberCompare(*params[0], *params[1]) <= 0);
 }
 
-ValuePtr greater_equal(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.size() != 2) {
-        throw LispError(">= expects 2 arguments.");
-    }
-    return std::make_shared<BooleanValue>(params[0]->asNumber() >=
-                                          params[1]->asNumber());
+ValuePtr greater_equal(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(numberCompare(*params[0], *params[1]) >= 0);
 }
 
-ValuePtr even(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty() || !params.front()->isNumber() ||
+ValuePtr even(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params.front()->isNumber() ||
         !(params.front()->isNumber() &&
           params.front()->asNumber() ==
               std::floor(params.front()->asNumber()))) {
         throw LispError("even? expects a numeric argument.");
     }
-    return std::make_shared<BooleanValue>(
-        (static_cast<int>(params.front()->asNumber()) % 2) == 0);
+    return BooleanValue::of(!numberIsOdd(*params.front()));
 }
 
-ValuePtr odd(const std::vector<ValuePtr>& params, EvalEnv& env) {
-    if (params.empty() || !params.front()->isNumber() ||
+ValuePtr odd(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (!params.front()->isNumber() ||
         !(params.front()->isNumber() &&
           params.front()->asNumber() ==
               std::floor(params.front()->asNumber()))) {
-        throw LispError("even? expects a numeric argument.");
+        throw LispError("odd? expects a numeric argument.");
+    }
+    return BooleanValue::of(numberIsOdd(*params.front()));
+}
+
+// 散列表库
+
+static HashTableValue& asHashTable(const ValuePtr& value, const char* name) {
+    if (value->getType() != ValueType::HASH_TABLE) {
+        throw LispError(std::string(name) + " expects a hash table.");
+    }
+    return static_cast<HashTableValue&>(*value);
+}
+
+// 比较方式可以写成符号 'eq?、'equal?，也可以直接传入内置过程
+static bool isTest(const ValuePtr& test, const char* name,
+                   BuiltinFuncType* func) {
+    if (auto symbol = test->asSymbol()) return symbol->getName() == name;
+    return test->getType() == ValueType::BUILTIN &&
+           static_cast<BuiltinProcValue&>(*test).getFunc() == func;
+}
+
+ValuePtr make_hash_table(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto kind = HashTableValue::Kind::EQUAL;  // 默认按 equal? 比较键
+    if (!params.empty()) {
+        if (isTest(params.front(), "eq?", eq)) {
+            kind = HashTableValue::Kind::EQ;
+        } else if (!isTest(params.front(), "equal?", equal)) {
+            throw LispError("make-hash-table expects eq? or equal?.");
+        }
+    }
+    return std::make_shared<HashTableValue>(kind);
+}
+
+ValuePtr hash_table_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->getType() ==
+                            ValueType::HASH_TABLE);
+}
+
+ValuePtr hash_ref(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto value = asHashTable(params[0], "hash-ref").get(params[1]);
+    if (value) return value;
+    if (params.size() == 3) return params[2];  // 键不存在时的默认值
+    throw LispError("hash-ref: no value found for key " +
+                    params[1]->toString());
+}
+
+ValuePtr hash_set(std::span<const ValuePtr> params, EvalEnv& env) {
+    asHashTable(params[0], "hash-set!").set(params[1], params[2]);
+    return NilValue::instance();
+}
+
+ValuePtr hash_remove(std::span<const ValuePtr> params, EvalEnv& env) {
+    asHashTable(params[0], "hash-remove!").remove(params[1]);
+    return NilValue::instance();
+}
+
+ValuePtr hash_has_key(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto& table = asHashTable(params[0], "hash-has-key?");
+    return BooleanValue::of(table.get(params[1]) != nullptr);
+}
+
+ValuePtr hash_count(std::span<const ValuePtr> params, EvalEnv& env) {
+    return IntegerValue::of(asHashTable(params[0], "hash-count").size());
+}
+
+ValuePtr hash_keys(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = NilValue::instance();
+    asHashTable(params[0], "hash-keys")
+        .forEach([&](const ValuePtr& key, const ValuePtr& value) {
+            result = makePooled<PairValue>(key, result);
+        });
+    return result;
+}
+
+ValuePtr hash_values(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = NilValue::instance();
+    asHashTable(params[0], "hash-values")
+        .forEach([&](const ValuePtr& key, const ValuePtr& value) {
+            result = makePooled<PairValue>(value, result);
+        });
+    return result;
+}
+
+ValuePtr hash_to_list(std::span<const ValuePtr> params, EvalEnv& env) {
+    ValuePtr result = NilValue::instance();
+    asHashTable(params[0], "hash->list")
+        .forEach([&](const ValuePtr& key, const ValuePtr& value) {
+            result = makePooled<PairValue>(makePooled<PairValue>(key, value),
+                                           result);
+        });
+    return result;
+}
+
+ValuePtr hash_for_each(std::span<const ValuePtr> params, EvalEnv& env) {
+    // 先取出全部键值对，过程中修改散列表也不影响遍历
+    std::vector<std::array<ValuePtr, 2>> entries;
+    asHashTable(params[0], "hash-for-each")
+        .forEach([&](const ValuePtr& key, const ValuePtr& value) {
+            entries.push_back({key, value});
+        });
+    for (const auto& entry : entries) {
+        env.apply(params[1], entry);
+    }
+    return NilValue::instance();
+}
+
+ValuePtr hash_clear(std::span<const ValuePtr> params, EvalEnv& env) {
+    asHashTable(params[0], "hash-clear!").clear();
+    return NilValue::instance();
+}
+
+// 向量库
+
+static std::vector<ValuePtr>& asVector(const ValuePtr& value,
+                                       const char* name) {
+    if (value->getType() != ValueType::VECTOR) {
+        throw LispError(std::string(name) + " expects a vector.");
     }
-    return std::make_shared<BooleanValue>(
-        (static_cast<int>(params.front()->asNumber()) % 2) != 0);
-}
\ No newline at end of file
+    return static_cast<VectorValue&>(*value).getValues();
+}
+
+static std::size_t asIndex(const ValuePtr& value, std::size_t size,
+                           const char* name) {
+    if (value->getType() != ValueType::INTEGER) {
+        throw LispError(std::string(name) + " expects an integer index.");
+    }
+    auto index = static_cast<IntegerValue&>(*value).getValue();
+    if (index < 0 || static_cast<std::size_t>(index) >= size) {
+        throw LispError(std::string(name) + ": index " +
+                        std::to_string(index) + " out of range.");
+    }
+    return static_cast<std::size_t>(index);
+}
+
+ValuePtr make_vector(std::span<const ValuePtr> params, EvalEnv& env) {
+    if (params[0]->getType() != ValueType::INTEGER ||
+        static_cast<IntegerValue&>(*params[0]).getValue() < 0) {
+        throw LispError("make-vector expects a non-negative length.");
+    }
+    auto size = static_cast<IntegerValue&>(*params[0]).getValue();
+    auto fill = params.size() == 2 ? params[1] : IntegerValue::of(0);
+    return std::make_shared<VectorValue>(
+        std::vector<ValuePtr>(static_cast<std::size_t>(size), fill));
+}
+
+ValuePtr vector(std::span<const ValuePtr> params, EvalEnv& env) {
+    return std::make_shared<VectorValue>(
+        std::vector<ValuePtr>(params.begin(), params.end()));
+}
+
+ValuePtr vector_q(std::span<const ValuePtr> params, EvalEnv& env) {
+    return BooleanValue::of(params.front()->getType() == ValueType::VECTOR);
+}
+
+ValuePtr vector_ref(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto& values = asVector(params[0], "vector-ref");
+    return values[asIndex(params[1], values.size(), "vector-ref")];
+}
+
+ValuePtr vector_set(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto& values = asVector(params[0], "vector-set!");
+    values[asIndex(params[1], values.size(), "vector-set!")] = params[2];
+    return NilValue::instance();
+}
+
+ValuePtr vector_length(std::span<const ValuePtr> params, EvalEnv& env) {
+    return IntegerValue::of(asVector(params[0], "vector-length").size());
+}
+
+ValuePtr vector_to_list(std::span<const ValuePtr> params, EvalEnv& env) {
+    return list(asVector(params[0], "vector->list"), env);
+}
+
+ValuePtr list_to_vector(std::span<const ValuePtr> params, EvalEnv& env) {
+    std::vector<ValuePtr> values;
+    auto current = params[0];
+    while (current->isPair()) {
+        auto& pair = static_cast<PairValue&>(*current);
+        values.push_back(pair.getLeft());
+        current = pair.getRight();
+    }
+    if (!current->isNil()) {
+        throw LispError("list->vector expects a proper list.");
+    }
+    return std::make_shared<VectorValue>(std::move(values));
+}
+
+ValuePtr vector_map(std::span<const ValuePtr> params, EvalEnv& env) {
+    // 复制一份，过程中修改原向量不影响遍历
+    auto source = asVector(params[1], "vector-map");
+    std::vector<ValuePtr> result;
+    result.reserve(source.size());
+    for (auto& element : source) {
+        result.push_back(env.apply(params[0], std::span(&element, 1)));
+    }
+    return std::make_shared<VectorValue>(std::move(result));
+}
+
+ValuePtr vector_fill(std::span<const ValuePtr> params, EvalEnv& env) {
+    auto& values = asVector(params[0], "vector-fill!");
+    std::fill(values.begin(), values.end(), params[1]);
+    return NilValue::instance();
+}
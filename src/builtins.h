@@ -1,64 +1,102 @@
 #ifndef BUILTINS_H
 #define BUILTINS_H
+#include <span>
+#include <string>
 #include <unordered_map>
-#include <vector>
 
 #include "value.h"
 
-extern std::unordered_map<
-    std::string, ValuePtr (*)(const std::vector<ValuePtr>&, EvalEnv& env)>
-    builtins;
+// 内置过程与它接受的实参个数，调用前由 BuiltinProcValue 统一检查
+struct BuiltinInfo {
+    BuiltinFuncType* func;
+    std::size_t minArgs;
+    std::size_t maxArgs;  // 个数不限时为 VARIADIC
+};
 
-ValuePtr null_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr number_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr pair_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr atom_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr boolean_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr integer_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr list_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr procedure_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr string_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr symbol_q(const std::vector<ValuePtr>& params, EvalEnv& env);
+extern const std::unordered_map<std::string, BuiltinInfo> builtins;
+
+ValuePtr null_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr number_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr pair_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr atom_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr boolean_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr integer_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr list_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr procedure_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr string_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr symbol_q(std::span<const ValuePtr> params, EvalEnv& env);
 //
-ValuePtr car(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr cdr(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr cons(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr length(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr list(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr append(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr b_map(const std::vector<ValuePtr>& args, EvalEnv& env);
-ValuePtr b_filter(const std::vector<ValuePtr>& args, EvalEnv& env);
-ValuePtr b_reduce(const std::vector<ValuePtr>& args, EvalEnv& env);
+ValuePtr car(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr cdr(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr cons(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr length(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr list(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr append(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr b_map(std::span<const ValuePtr> args, EvalEnv& env);
+ValuePtr b_filter(std::span<const ValuePtr> args, EvalEnv& env);
+ValuePtr b_reduce(std::span<const ValuePtr> args, EvalEnv& env);
 //核心
-ValuePtr print(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr display(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr exit_b(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr newline(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr apply(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr display(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr displayln(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr error(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr eval(const std::vector<ValuePtr>& params, EvalEnv& env);
+ValuePtr print(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr display(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr exit_b(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr newline(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr apply(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr display(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr displayln(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr error(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr eval(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr load(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr write_fasl(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr read_fasl(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr flush_output(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr open_output_string(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr get_output_string(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr collect_garbage(std::span<const ValuePtr> params, EvalEnv& env);
+//
+ValuePtr add(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr subtract(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr multiply(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr divide(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr abs_f(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr exp(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr quotient(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr modulo(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr remainder(std::span<const ValuePtr> params, EvalEnv& env);
+//
+ValuePtr eq(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr eqv(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr b_not(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr equal_sym(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr zero_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr equal(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr less(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr greater(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr less_equal(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr greater_equal(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr even(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr odd(std::span<const ValuePtr> params, EvalEnv& env);
 //
-ValuePtr add(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr subtract(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr multiply(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr divide(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr abs_f(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr exp(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr quotient(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr modulo(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr remainder(const std::vector<ValuePtr>& params, EvalEnv& env);
+ValuePtr make_hash_table(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_table_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_ref(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_set(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_remove(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_has_key(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_count(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_keys(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_values(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_to_list(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_for_each(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr hash_clear(std::span<const ValuePtr> params, EvalEnv& env);
 //
-ValuePtr eq(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr b_not(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr equal_sym(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr zero_q(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr equal(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr less(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr greater(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr less_equal(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr greater_equal(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr even(const std::vector<ValuePtr>& params, EvalEnv& env);
-ValuePtr odd(const std::vector<ValuePtr>& params, EvalEnv& env);
+ValuePtr make_vector(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_q(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_ref(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_set(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_length(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_to_list(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr list_to_vector(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_map(std::span<const ValuePtr> params, EvalEnv& env);
+ValuePtr vector_fill(std::span<const ValuePtr> params, EvalEnv& env);
 #endif
\ No newline at end of file
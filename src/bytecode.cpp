@@ -0,0 +1,73 @@
+#include "bytecode.h"
+
+#include <limits>
+
+#include "error.h"
+#include "node.h"
+
+std::size_t Compiler::emit(OpCode op, std::size_t operand, std::size_t aux) {
+    if (operand > std::numeric_limits<std::uint32_t>::max() ||
+        aux > std::numeric_limits<std::uint16_t>::max()) {
+        throw LispError("Expression too large to compile");
+    }
+    code->instructions.push_back({op, static_cast<std::uint16_t>(aux),
+                                  static_cast<std::uint32_t>(operand)});
+    return code->instructions.size() - 1;
+}
+
+void Compiler::patch(std::size_t at) {
+    code->instructions[at].operand =
+        static_cast<std::uint32_t>(code->instructions.size());
+}
+
+void Compiler::nameLocal(std::size_t at, Symbol name) {
+    code->localNames.emplace(at, name);
+}
+
+std::uint32_t Compiler::addConstant(ValuePtr value) {
+    code->constants.push_back(std::move(value));
+    return static_cast<std::uint32_t>(code->constants.size() - 1);
+}
+
+std::uint32_t Compiler::addName(Symbol name) {
+    for (std::size_t i = 0; i < code->names.size(); ++i) {
+        if (code->names[i] == name) return static_cast<std::uint32_t>(i);
+    }
+    code->names.push_back(name);
+    return static_cast<std::uint32_t>(code->names.size() - 1);
+}
+
+std::uint32_t Compiler::addLambda(std::shared_ptr<const LambdaNode> lambda) {
+    code->lambdas.push_back(std::move(lambda));
+    return static_cast<std::uint32_t>(code->lambdas.size() - 1);
+}
+
+void Compiler::compileSequence(const std::vector<NodePtr>& body, bool tail) {
+    if (body.empty()) {
+        emit(OpCode::CONST, addConstant(NilValue::instance()));
+        return;
+    }
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        bool last = i + 1 == body.size();
+        body[i]->compile(*this, tail && last);
+        if (!last) emit(OpCode::POP);
+    }
+}
+
+CodePtr Compiler::finish() {
+    emit(OpCode::RETURN);
+    code->caches.resize(code->names.size());
+    return code;
+}
+
+CodePtr Compiler::compileTopLevel(const Node& node) {
+    Compiler compiler;
+    node.compile(compiler, false);
+    return compiler.finish();
+}
+
+CodePtr Compiler::compileBody(const std::vector<NodePtr>& body) {
+    Compiler compiler;
+    compiler.compileSequence(body, true);
+    return compiler.finish();
+}
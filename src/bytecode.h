@@ -0,0 +1,74 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "eval_env.h"
+#include "value.h"
+
+class Node;
+class LambdaNode;
+
+enum class OpCode : std::uint8_t {
+    CONST,               // 压入 constants[operand]
+    LOAD_GLOBAL,         // 压入全局变量 names[operand] 的值
+    LOAD_LOCAL,          // 压入向外 aux 层帧中第 operand 个槽位的值
+    DEFINE_GLOBAL,       // 弹出栈顶并绑定到全局变量 names[operand]，压入 nil
+    DEFINE_LOCAL,        // 弹出栈顶并写入当前帧第 operand 个槽位，压入 nil
+    POP,                 // 丢弃栈顶
+    JUMP,                // 跳转到 operand
+    JUMP_IF_FALSE,       // 弹出栈顶，若为 #f 则跳转
+    JUMP_IF_FALSE_KEEP,  // 栈顶为 #f 则保留并跳转，否则弹出
+    JUMP_IF_TRUE_KEEP,   // 栈顶不为 #f 则保留并跳转，否则弹出
+    CALL,                // 调用，operand 为实参个数
+    TAIL_CALL,           // 尾调用，复用当前帧
+    RETURN,              // 返回栈顶
+    CLOSURE,             // 以 lambdas[operand] 与当前环境创建闭包
+    ENTER,               // 弹出 aux 个值，进入大小为 operand 的新帧
+    LEAVE,               // 回到父环境
+    LIST,                // 弹出 operand 个值构造列表
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint16_t aux;  // 第二个操作数：帧深度或实参个数
+    std::uint32_t operand;
+};
+
+struct Code {
+    std::vector<Instruction> instructions;
+    std::vector<ValuePtr> constants;
+    std::vector<Symbol> names;
+    mutable std::vector<GlobalCache> caches;  // 与 names 一一对应
+    // LOAD_LOCAL 指令的位置到变量名，只在报告未定义变量时查找
+    std::unordered_map<std::size_t, Symbol> localNames;
+    std::vector<std::shared_ptr<const LambdaNode>> lambdas;
+};
+
+using CodePtr = std::shared_ptr<const Code>;
+
+// 把节点树降低为字节码指令序列
+class Compiler {
+    std::shared_ptr<Code> code = std::make_shared<Code>();
+
+public:
+    // 操作数超出指令字段的范围时抛出 LispError，而不是悄悄截断
+    std::size_t emit(OpCode op, std::size_t operand = 0, std::size_t aux = 0);
+    void patch(std::size_t at);  // 把 at 处跳转指令的目标设为当前位置
+    void nameLocal(std::size_t at, Symbol name);
+    std::uint32_t addConstant(ValuePtr value);
+    std::uint32_t addName(Symbol name);
+    std::uint32_t addLambda(std::shared_ptr<const LambdaNode> lambda);
+    void compileSequence(const std::vector<std::shared_ptr<const Node>>& body,
+                         bool tail);
+    CodePtr finish();
+
+    static CodePtr compileTopLevel(const Node& node);
+    static CodePtr compileBody(
+        const std::vector<std::shared_ptr<const Node>>& body);
+};
+
+#endif
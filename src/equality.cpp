@@ -0,0 +1,130 @@
+#include "equality.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "numeric.h"
+
+bool isEq(const ValuePtr& a, const ValuePtr& b) {
+    if (a == b) return true;
+    if (a->getType() != b->getType()) return false;
+    switch (a->getType()) {
+        case ValueType::BOOLEAN: return a->asBoolean() == b->asBoolean();
+        case ValueType::NIL: return true;
+        case ValueType::INTEGER: return numberCompare(*a, *b) == 0;
+        default: return false;
+    }
+}
+
+bool isEqv(const ValuePtr& a, const ValuePtr& b) {
+    if (isEq(a, b)) return true;
+    // 类型标记相同保证了精确性相同
+    return a->isNumber() && a->getType() == b->getType() &&
+           numberCompare(*a, *b) == 0;
+}
+
+bool isEqual(const ValuePtr& a, const ValuePtr& b) {
+    // 用显式的栈代替递归，长列表不会耗尽 C++ 栈
+    std::vector<std::pair<Value*, Value*>> pending{{a.get(), b.get()}};
+    while (!pending.empty()) {
+        auto [x, y] = pending.back();
+        pending.pop_back();
+        if (x == y) continue;
+        if (x->getType() != y->getType()) return false;
+        if (x->isPair()) {
+            auto& left = static_cast<PairValue&>(*x);
+            auto& right = static_cast<PairValue&>(*y);
+            pending.emplace_back(left.getRight().get(), right.getRight().get());
+            pending.emplace_back(left.getLeft().get(), right.getLeft().get());
+        } else if (x->getType() == ValueType::VECTOR) {
+            auto& left = static_cast<VectorValue&>(*x).getValues();
+            auto& right = static_cast<VectorValue&>(*y).getValues();
+            if (left.size() != right.size()) return false;
+            for (std::size_t i = left.size(); i-- > 0;) {
+                pending.emplace_back(left[i].get(), right[i].get());
+            }
+        } else if (x->isString()) {
+            if (static_cast<StringValue&>(*x).getValue() !=
+                static_cast<StringValue&>(*y).getValue()) {
+                return false;
+            }
+        } else if (x->isNumber()) {
+            if (numberCompare(*x, *y) != 0) return false;
+        } else if (x->isBoolean()) {
+            if (x->asBoolean() != y->asBoolean()) return false;
+        } else if (!x->isNil()) {
+            return false;  // 符号、过程等只有同一对象才相等
+        }
+    }
+    return true;
+}
+
+static std::size_t mix(std::size_t seed, std::size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+static std::size_t hashIdentity(Value& value) {
+    switch (value.getType()) {
+        case ValueType::BOOLEAN: return value.asBoolean() ? 1 : 2;
+        case ValueType::NIL: return 3;
+        case ValueType::INTEGER:
+            return std::hash<std::int64_t>()(
+                static_cast<IntegerValue&>(value).getValue());
+        default: return std::hash<const Value*>()(&value);
+    }
+}
+
+std::size_t hashEq(const ValuePtr& value) {
+    return hashIdentity(*value);
+}
+
+// 只散列前若干个结点，超长或共享很多的结构也能很快算完
+std::size_t hashEqual(const ValuePtr& value) {
+    constexpr int BUDGET = 64;
+    std::size_t hash = 0;
+    int visited = 0;
+    std::vector<Value*> pending{value.get()};
+    while (!pending.empty() && visited++ < BUDGET) {
+        Value* current = pending.back();
+        pending.pop_back();
+        hash = mix(hash, static_cast<std::size_t>(current->getType()));
+        // 预算之外的子节点不会被访问，不再入栈，长向量也只压入开头几个元素
+        auto room = static_cast<std::size_t>(
+            std::max(0, BUDGET - visited - static_cast<int>(pending.size())));
+        switch (current->getType()) {
+            case ValueType::PAIR: {
+                auto& pair = static_cast<PairValue&>(*current);
+                if (room >= 2) pending.push_back(pair.getRight().get());
+                if (room >= 1) pending.push_back(pair.getLeft().get());
+                break;
+            }
+            case ValueType::VECTOR: {
+                auto& values = static_cast<VectorValue&>(*current).getValues();
+                auto count = std::min(room, values.size());
+                for (auto i = count; i > 0; --i) {
+                    pending.push_back(values[i - 1].get());
+                }
+                break;
+            }
+            case ValueType::STRING:
+                hash = mix(hash, std::hash<std::string>()(
+                                     static_cast<StringValue&>(*current)
+                                         .getValue()));
+                break;
+            case ValueType::BIGINT:
+                hash = mix(hash, static_cast<BigIntValue&>(*current)
+                                     .getValue()
+                                     .hash());
+                break;
+            case ValueType::NUMERIC:
+                hash = mix(hash, std::hash<double>()(current->asNumber()));
+                break;
+            default:
+                hash = mix(hash, hashIdentity(*current));
+                break;
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,19 @@
+#ifndef EQUALITY_H
+#define EQUALITY_H
+
+#include <cstddef>
+
+#include "value.h"
+
+// eq?：同一对象。布尔值、空表与 int64 整数按值比较，相当于立即数
+bool isEq(const ValuePtr& a, const ValuePtr& b);
+// eqv?：在 eq? 的基础上，精确性相同且数值相等的数也相等
+bool isEqv(const ValuePtr& a, const ValuePtr& b);
+// equal?：逐个比较序对、向量的结构与字符串内容，遇到第一处不同即返回
+bool isEqual(const ValuePtr& a, const ValuePtr& b);
+
+// 与上面两种相等判断一致的散列函数：eq? 相等的值散列相同，equal? 亦然
+std::size_t hashEq(const ValuePtr& value);
+std::size_t hashEqual(const ValuePtr& value);
+
+#endif
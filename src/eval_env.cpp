@@ -2,26 +2,98 @@
 
 #include <algorithm>
 #include <iterator>
+#include <memory>
+#include <new>
 #include <unordered_map>
 
-#include "value.h"
+#include "analyzer.h"
 #include "builtins.h"
+#include "bytecode.h"
 #include "error.h"
-#include "forms.h"
+#include "gc.h"
+#include "pool.h"
 #include "value.h"
+#include "vm.h"
 
-EvalEnv::EvalEnv() {
-    for (const auto& builtin : builtins) {
-        symbolTable[builtin.first] =
-            std::make_shared<BuiltinProcValue>(builtin.second);
-    }
+namespace {
+
+// 局部帧连同它的槽位数组所占的字节数
+constexpr std::size_t frameBytes(std::size_t slots) {
+    return sizeof(EvalEnv) + slots * sizeof(ValuePtr);
+}
+
+template <std::size_t Slots>
+using FramePool = FixedPool<frameBytes(Slots), alignof(EvalEnv)>;
+
+// 按槽位数分档从内存池中取出帧，更大的帧直接向系统申请
+void* allocateFrame(std::size_t slots) {
+    if (slots <= 2) return FramePool<2>::instance().allocate();
+    if (slots <= 4) return FramePool<4>::instance().allocate();
+    if (slots <= 8) return FramePool<8>::instance().allocate();
+    return ::operator new(frameBytes(slots));
+}
+
+void deallocateFrame(void* frame, std::size_t slots) {
+    if (slots <= 2) return FramePool<2>::instance().deallocate(frame);
+    if (slots <= 4) return FramePool<4>::instance().deallocate(frame);
+    if (slots <= 8) return FramePool<8>::instance().deallocate(frame);
+    ::operator delete(frame);
 }
 
-EvalEnv::EvalEnv(std::shared_ptr<EvalEnv> parent) : parent(parent) {
-    for (const auto& builtin : builtins) {
-        symbolTable[builtin.first] =
-            std::make_shared<BuiltinProcValue>(builtin.second);
+}  // namespace
+
+struct EvalEnv::FrameDeleter {
+    void operator()(EvalEnv* env) const {
+        auto slots = env->slots.size();
+        env->~EvalEnv();
+        deallocateFrame(env, slots);
     }
+};
+
+const std::shared_ptr<EvalEnv>& EvalEnv::builtinEnv() {
+    static const std::shared_ptr<EvalEnv> root = [] {
+        auto env = std::shared_ptr<EvalEnv>(new EvalEnv(nullptr, {}));
+        env->symbolTable = std::make_unique<Bindings>();
+        for (const auto& [name, info] : builtins) {
+            (*env->symbolTable)[SymbolValue::intern(name).get()] =
+                std::make_shared<BuiltinProcValue>(name, info.func,
+                                                   info.minArgs, info.maxArgs);
+        }
+        return env;
+    }();
+    return root;
+}
+
+EvalEnv::EvalEnv()
+    : parent(builtinEnv()),
+      global(this),
+      symbolTable(std::make_unique<Bindings>()) {
+    CycleCollector::track(this);
+}
+
+EvalEnv::EvalEnv(std::shared_ptr<EvalEnv> parent, std::span<ValuePtr> slots)
+    : parent(std::move(parent)), slots(slots) {
+    global = this->parent ? this->parent->global : this;
+    if (this->parent) engine = this->parent->engine;
+    CycleCollector::track(this);
+}
+
+EvalEnv::~EvalEnv() {
+    if (symbolTable && !symbolTable->empty()) ++bindingVersion;
+    CycleCollector::untrack(this);
+    std::destroy(slots.begin(), slots.end());
+}
+
+std::shared_ptr<EvalEnv> EvalEnv::createFrame(std::shared_ptr<EvalEnv> parent,
+                                              std::size_t frameSize) {
+    void* memory = allocateFrame(frameSize);
+    auto slots = reinterpret_cast<ValuePtr*>(static_cast<char*>(memory) +
+                                             sizeof(EvalEnv));
+    std::uninitialized_value_construct_n(slots, frameSize);
+    auto env = new (memory)
+        EvalEnv(std::move(parent), std::span<ValuePtr>(slots, frameSize));
+    return std::shared_ptr<EvalEnv>(env, FrameDeleter(),
+                                    PoolAllocator<EvalEnv>());
 }
 
 std::vector<ValuePtr> EvalEnv::evalList(ValuePtr expr) {
@@ -31,62 +103,63 @@ std::vector<ValuePtr> EvalEnv::evalList(ValuePtr expr) {
     return result;
 }
 
-ValuePtr EvalEnv::apply(ValuePtr proc, std::vector<ValuePtr> args) {
-    if (auto builtinProc = std::dynamic_pointer_cast<BuiltinProcValue>(proc)) {
+ValuePtr EvalEnv::apply(const ValuePtr& proc, std::span<const ValuePtr> args) {
+    if (proc->getType() == ValueType::BUILTIN) {
         // 调用内置过程
-        return builtinProc->getFunc()(args, *this);
-    } else if (auto lambdaProc = std::dynamic_pointer_cast<LambdaValue>(proc)) {
-        return lambdaProc->apply(args);  // 调用 Lambda 过程
+        return static_cast<BuiltinProcValue&>(*proc).call(args, *this);
+    } else if (proc->getType() == ValueType::LAMBDA) {
+        // 调用 Lambda 过程
+        return static_cast<LambdaValue&>(*proc).apply(args);
     } else {
         throw LispError("Unimplemented");
     }
 }
 
 std::shared_ptr<EvalEnv> EvalEnv::createChild(
-    const std::vector<std::string>& params, const std::vector<ValuePtr>& args) {
-    auto childEnv = std::make_shared<EvalEnv>(
-        shared_from_this());  // 使用当前环境作为父环境
-    if (params.size() != args.size()) {
-        throw LispError("Parameter and argument counts do not match.");
-    }
-    for (size_t i = 0; i < params.size(); ++i) {
-        childEnv->symbolTable[params[i]] = args[i];  // 绑定参数名到实参值
-    }
+    std::size_t frameSize, std::span<const ValuePtr> args) {
+    auto childEnv = createFrame(shared_from_this(), frameSize);
+    std::ranges::copy(args, childEnv->slots.begin());  // 绑定实参到参数槽位
     return childEnv;
 }
 
-ValuePtr EvalEnv::lookupBinding(const std::string& name) {
-    auto it = symbolTable.find(name);
-    if (it != symbolTable.end()) {
-        return it->second;
-    } else if (parent != nullptr) {
-        return parent->lookupBinding(name);  // 向上追溯
-    } else {
-        throw LispError("Variable " + name + " not defined.");
+ValuePtr EvalEnv::lookupBinding(Symbol name) {
+    return lookupCell(name);
+}
+
+const ValuePtr& EvalEnv::lookupCell(Symbol name) {
+    for (EvalEnv* env = this; env; env = env->parent.get()) {  // 向上追溯
+        if (!env->symbolTable) continue;
+        auto it = env->symbolTable->find(name);
+        if (it != env->symbolTable->end()) return it->second;
     }
+    throw LispError("Variable " + name->getName() + " not defined.");
+}
+
+void EvalEnv::defineGlobal(Symbol name, ValuePtr value) {
+    auto [it, inserted] = symbolTable->try_emplace(name);
+    // 新名字可能遮蔽内置环境中的同名绑定
+    if (inserted) ++bindingVersion;
+    it->second = std::move(value);
+}
+
+void EvalEnv::clearBindings() {
+    if (!symbolTable || symbolTable->empty()) return;
+    ++bindingVersion;
+    symbolTable->clear();
 }
 
 ValuePtr EvalEnv::eval(ValuePtr expr) {
-    if (expr->isSelfEvaluating() || expr->isProcedure()) {
-        return expr;
-    } else if (expr->isNil()) {
-        throw LispError("Evaluating nil is prohibited.");
-    } else if (auto name = expr->asSymbol()) {
-        return lookupBinding(*name);
-    } else {
-        std::vector<ValuePtr> v = expr->toVector();
-        auto n = v[0]->asSymbol();
-        auto it = SPECIAL_FORMS.find(*n);
-        if (it != SPECIAL_FORMS.end()) {
-            std::vector<ValuePtr> args(v.begin() + 1, v.end());
-            return it->second(args, *this);
+    ValuePtr result;
+    {
+        Analyzer analyzer;
+        auto node = analyzer.analyze(expr);
+        if (engine == EvalEngine::BYTECODE) {
+            result = VM::execute(Compiler::compileTopLevel(*node),
+                                 shared_from_this());
         } else {
-            // 处理非特殊形式的列表表达式
-            ValuePtr proc = eval(v[0]);
-            std::vector<ValuePtr> args;
-            std::transform(v.begin() + 1, v.end(), std::back_inserter(args),
-                           [this](ValuePtr arg) { return this->eval(arg); });
-            return apply(proc, args);
+            result = node->eval(*this);
         }
     }
-}
\ No newline at end of file
+    CycleCollector::maybeCollect();
+    return result;
+}
@@ -1,29 +1,98 @@
 #ifndef EVAL_ENV_H
 #define EVAL_ENV_H
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 class Value;
+class SymbolValue;
 using ValuePtr = std::shared_ptr<Value>;
+using Symbol = const SymbolValue*;
+
+enum class EvalEngine {
+    TREE,      // 直接执行分析得到的节点树
+    BYTECODE,  // 编译为字节码后由虚拟机执行
+};
+
+class EvalEnv;
+
+// 全局变量引用处的内联缓存，记住上次查到的绑定槽位
+struct GlobalCache {
+    const EvalEnv* global = nullptr;
+    std::uint64_t version = 0;
+    const ValuePtr* cell = nullptr;
+};
+
 class EvalEnv : public std::enable_shared_from_this<EvalEnv> {
+    friend class CycleCollector;
+    friend class ImageReader;
+
     std::shared_ptr<EvalEnv> parent;
-    EvalEnv();
+    EvalEnv* global;  // 所在的全局环境，全局变量总在这里查找
+    EvalEngine engine = EvalEngine::TREE;
+    EvalEnv* prevTracked = nullptr;  // CycleCollector 中的前后环境
+    EvalEnv* nextTracked = nullptr;
+    // 绑定槽位的版本号。新增或删除绑定时递增，使所有 GlobalCache 失效；
+    // 给已有的名字重新赋值写入原来的槽位，缓存仍然有效
+    static inline std::uint64_t bindingVersion = 1;
+    struct FrameDeleter;
+
+    EvalEnv(std::shared_ptr<EvalEnv> parent, std::span<ValuePtr> slots);
+    // 所有全局环境共享的根环境，启动时创建一次内置过程，此后不再修改
+    static const std::shared_ptr<EvalEnv>& builtinEnv();
+    // 分配有 frameSize 个空槽位的局部帧，槽位数组紧跟在帧对象之后
+    static std::shared_ptr<EvalEnv> createFrame(
+        std::shared_ptr<EvalEnv> parent, std::size_t frameSize);
 
 public:
-    std::shared_ptr<EvalEnv> createChild(const std::vector<std::string>& params,
-                                         const std::vector<ValuePtr>& args);
-    std::unordered_map<std::string, ValuePtr> symbolTable;
-    // EvalEnv();
-    EvalEnv(std::shared_ptr<EvalEnv> parent);
-    static std::shared_ptr<EvalEnv> createGlobal() {
-        return std::shared_ptr<EvalEnv>(new EvalEnv());
+    using Bindings = std::unordered_map<Symbol, ValuePtr>;
+
+    // 创建大小为 frameSize 的局部帧，前 args.size() 个槽位依次绑定实参
+    std::shared_ptr<EvalEnv> createChild(std::size_t frameSize,
+                                         std::span<const ValuePtr> args);
+    // 全局环境与内置环境按名字查找的绑定，局部帧没有这张表
+    std::unique_ptr<Bindings> symbolTable;
+    std::span<ValuePtr> slots;  // 局部帧的绑定，按 (深度, 序号) 访问
+    EvalEnv();
+    ~EvalEnv();
+    EvalEnv(const EvalEnv&) = delete;
+    EvalEnv& operator=(const EvalEnv&) = delete;
+    static std::shared_ptr<EvalEnv> createGlobal(
+        EvalEngine engine = EvalEngine::TREE) {
+        auto env = std::shared_ptr<EvalEnv>(new EvalEnv());
+        env->engine = engine;
+        return env;
+    }
+    const std::shared_ptr<EvalEnv>& getParent() const {
+        return parent;
+    }
+    EvalEnv& getGlobal() const {
+        return *global;
+    }
+    EvalEnv& ancestor(std::size_t depth) {
+        EvalEnv* env = this;
+        while (depth-- > 0) env = env->parent.get();
+        return *env;
     }
     ValuePtr eval(ValuePtr expr);
     std::vector<ValuePtr> evalList(ValuePtr expr);
-    ValuePtr apply(ValuePtr proc, std::vector<ValuePtr> args);
-    ValuePtr lookupBinding(const std::string& name);
+    // 以 args 为实参调用过程，实参只在调用期间借用
+    ValuePtr apply(const ValuePtr& proc, std::span<const ValuePtr> args);
+    ValuePtr lookupBinding(Symbol name);
+    // 返回名字所在的绑定槽位，沿父环境向上查找，找不到时抛出 LispError
+    const ValuePtr& lookupCell(Symbol name);
+    // 在全局环境中查找，缓存命中时只需一次比较
+    const ValuePtr& lookupGlobal(Symbol name, GlobalCache& cache) {
+        if (cache.global != this || cache.version != bindingVersion) {
+            cache = {this, bindingVersion, &lookupCell(name)};
+        }
+        return *cache.cell;
+    }
+    void defineGlobal(Symbol name, ValuePtr value);
+    void clearBindings();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "gc.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "eval_env.h"
+#include "hash_table.h"
+#include "value.h"
+
+EvalEnv* CycleCollector::envHead = nullptr;
+ContainerValue* CycleCollector::containerHead = nullptr;
+std::size_t CycleCollector::tracked = 0;
+std::size_t CycleCollector::threshold = 4096;
+
+template <typename T>
+void CycleCollector::link(T*& head, T* object) {
+    object->nextTracked = head;
+    if (head) head->prevTracked = object;
+    head = object;
+}
+
+template <typename T>
+void CycleCollector::unlink(T*& head, T* object) {
+    if (object->prevTracked) {
+        object->prevTracked->nextTracked = object->nextTracked;
+    } else {
+        head = object->nextTracked;
+    }
+    if (object->nextTracked) {
+        object->nextTracked->prevTracked = object->prevTracked;
+    }
+}
+
+void CycleCollector::track(EvalEnv* env) {
+    link(envHead, env);
+    ++tracked;
+}
+
+void CycleCollector::untrack(EvalEnv* env) {
+    unlink(envHead, env);
+    --tracked;
+}
+
+void CycleCollector::track(ContainerValue* container) {
+    link(containerHead, container);
+    ++tracked;
+}
+
+void CycleCollector::untrack(ContainerValue* container) {
+    unlink(containerHead, container);
+    --tracked;
+}
+
+void CycleCollector::collectAndGrow() {
+    collect();
+    threshold = std::max<std::size_t>(4096, tracked * 2);
+}
+
+namespace {
+
+// 参与回收的对象：环境以及序对、闭包、向量等容器。叶子值不会成环，不必记录
+struct GcObject {
+    EvalEnv* env = nullptr;
+    Value* value = nullptr;
+    const ValuePtr* holder = nullptr;  // 序对与闭包：某个持有它的指针，用于保活
+    long refs = 0;                     // 全部强引用数
+    long internal = 0;                 // 其中来自其它参与对象的引用数
+    bool reachable = false;
+    std::vector<std::size_t> edges;
+};
+
+bool isContainer(const Value* value) {
+    return value->getType() == ValueType::VECTOR ||
+           value->getType() == ValueType::HASH_TABLE;
+}
+
+// 不被 shared_ptr 管理的对象无法判断，按外部可达处理
+long countRefs(long useCount) {
+    return useCount == 0 ? std::numeric_limits<long>::max() : useCount;
+}
+
+class Graph {
+public:
+    std::vector<GcObject> objects;
+    std::unordered_map<const void*, std::size_t> index;
+    std::vector<std::size_t> pending;
+
+    void addEnv(EvalEnv* env) {
+        if (index.count(env)) return;
+        GcObject object;
+        object.env = env;
+        object.refs = countRefs(env->weak_from_this().use_count());
+        insert(env, std::move(object));
+    }
+
+    std::size_t addContainer(ContainerValue* container) {
+        Value* key = container;
+        if (auto it = index.find(key); it != index.end()) return it->second;
+        GcObject object;
+        object.value = key;
+        object.refs = countRefs(container->weak_from_this().use_count());
+        return insert(key, std::move(object))->second;
+    }
+
+    void edgeToEnv(std::size_t from, EvalEnv* env) {
+        addEnv(env);
+        link(from, index[env]);
+    }
+
+    void edgeToValue(std::size_t from, const ValuePtr& value) {
+        if (!value) return;
+        auto key = value.get();
+        if (isContainer(key)) {
+            link(from, addContainer(static_cast<ContainerValue*>(key)));
+            return;
+        }
+        auto it = index.find(key);
+        if (it == index.end()) {
+            if (!key->isPair() && key->getType() != ValueType::LAMBDA) return;
+            GcObject object;
+            object.value = key;
+            object.holder = &value;
+            object.refs = value.use_count();
+            it = insert(key, std::move(object));
+        }
+        link(from, it->second);
+    }
+
+    // 展开一个对象的出边
+    void scan(std::size_t i) {
+        if (auto env = objects[i].env) {
+            if (env->getParent()) edgeToEnv(i, env->getParent().get());
+            for (const auto& slot : env->slots) edgeToValue(i, slot);
+            if (env->symbolTable) {
+                for (const auto& [name, value] : *env->symbolTable) {
+                    edgeToValue(i, value);
+                }
+            }
+        } else {
+            auto value = objects[i].value;
+            if (value->isPair()) {
+                auto pair = static_cast<PairValue*>(value);
+                edgeToValue(i, pair->getLeft());
+                edgeToValue(i, pair->getRight());
+            } else if (value->getType() == ValueType::VECTOR) {
+                for (const auto& element :
+                     static_cast<VectorValue*>(value)->getValues()) {
+                    edgeToValue(i, element);
+                }
+            } else if (value->getType() == ValueType::HASH_TABLE) {
+                static_cast<HashTableValue*>(value)->forEach(
+                    [&](const ValuePtr& key, const ValuePtr& entry) {
+                        edgeToValue(i, key);
+                        edgeToValue(i, entry);
+                    });
+            } else {
+                auto lambda = static_cast<LambdaValue*>(value);
+                if (lambda->getEnv()) edgeToEnv(i, lambda->getEnv().get());
+            }
+        }
+    }
+
+private:
+    std::unordered_map<const void*, std::size_t>::iterator insert(
+        const void* key, GcObject object) {
+        objects.push_back(std::move(object));
+        pending.push_back(objects.size() - 1);
+        return index.emplace(key, objects.size() - 1).first;
+    }
+
+    void link(std::size_t from, std::size_t to) {
+        objects[from].edges.push_back(to);
+        ++objects[to].internal;
+    }
+};
+
+}  // namespace
+
+std::size_t CycleCollector::collect() {
+    Graph graph;
+    for (auto env = envHead; env; env = env->nextTracked) {
+        graph.addEnv(env);
+    }
+    // 容器直接从链表中找出，只由彼此引用、不经过任何环境的环也能回收
+    for (auto container = containerHead; container;
+         container = container->nextTracked) {
+        graph.addContainer(container);
+    }
+    while (!graph.pending.empty()) {
+        auto i = graph.pending.back();
+        graph.pending.pop_back();
+        graph.scan(i);
+    }
+
+    // 引用数多于内部引用数的对象还被求值栈、节点树等外部持有，是根
+    auto& objects = graph.objects;
+    std::vector<std::size_t> stack;
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        if (objects[i].refs > objects[i].internal) {
+            objects[i].reachable = true;
+            stack.push_back(i);
+        }
+    }
+    while (!stack.empty()) {
+        auto i = stack.back();
+        stack.pop_back();
+        for (auto to : objects[i].edges) {
+            if (!objects[to].reachable) {
+                objects[to].reachable = true;
+                stack.push_back(to);
+            }
+        }
+    }
+
+    // 先全部持有再断开，避免断开途中对象被释放
+    std::vector<std::shared_ptr<EvalEnv>> envs;
+    std::vector<ValuePtr> values;
+    for (const auto& object : objects) {
+        if (object.reachable) continue;
+        if (object.env) {
+            envs.push_back(object.env->shared_from_this());
+        } else if (isContainer(object.value)) {
+            values.push_back(
+                static_cast<ContainerValue*>(object.value)->shared_from_this());
+        } else if (object.value->isPair()) {
+            values.push_back(*object.holder);
+        }
+    }
+    for (const auto& env : envs) {
+        std::fill(env->slots.begin(), env->slots.end(), nullptr);
+        env->clearBindings();
+    }
+    for (const auto& value : values) {
+        if (value->isPair()) {
+            auto& pair = static_cast<PairValue&>(*value);
+            pair.setLeft(NilValue::instance());
+            pair.setRight(NilValue::instance());
+        } else if (value->getType() == ValueType::VECTOR) {
+            static_cast<VectorValue&>(*value).getValues().clear();
+        } else {
+            static_cast<HashTableValue&>(*value).clear();
+        }
+    }
+    return envs.size() + values.size();
+}
@@ -0,0 +1,39 @@
+#ifndef GC_H
+#define GC_H
+
+#include <cstddef>
+
+class ContainerValue;
+class EvalEnv;
+
+// 引用计数的补充：找出只被彼此引用的环境与容器（如递归的内部定义形成的
+// “环境 ↔ 闭包”环、引用自身的散列表），断开它们的引用，让引用计数把它们释放
+class CycleCollector {
+    static EvalEnv* envHead;              // 所有存活环境组成的侵入式链表
+    static ContainerValue* containerHead;  // 所有存活的向量与散列表
+    static std::size_t tracked;            // 两个链表的总长
+    static std::size_t threshold;
+
+    static void collectAndGrow();
+    // 侵入式双向链表的插入与摘除，环境和容器各用一条
+    template <typename T>
+    static void link(T*& head, T* object);
+    template <typename T>
+    static void unlink(T*& head, T* object);
+
+public:
+    static void track(EvalEnv* env);
+    static void untrack(EvalEnv* env);
+    static void track(ContainerValue* container);
+    static void untrack(ContainerValue* container);
+    // 存活对象过多时回收一次。只在安全点调用：此时一切正在使用的环境和值
+    // 都由 C++ 局部变量、虚拟机的帧或操作数栈中的强引用持有，
+    // 这些外部引用使它们成为根，不会被断开
+    static void maybeCollect() {
+        if (tracked >= threshold) collectAndGrow();
+    }
+    // 返回被断开的环境与容器个数
+    static std::size_t collect();
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "hash_table.h"
+
+#include <algorithm>
+
+#include "equality.h"
+
+static constexpr std::size_t MIN_CAPACITY = 8;
+
+HashTableValue::HashTableValue(Kind kind)
+    : ContainerValue(ValueType::HASH_TABLE),
+      kind(kind),
+      entries(MIN_CAPACITY) {}
+
+std::size_t HashTableValue::hashOf(const ValuePtr& key) const {
+    return kind == Kind::EQ ? hashEq(key) : hashEqual(key);
+}
+
+bool HashTableValue::keysEqual(const ValuePtr& a, const ValuePtr& b) const {
+    return kind == Kind::EQ ? isEq(a, b) : isEqual(a, b);
+}
+
+std::size_t HashTableValue::find(const ValuePtr& key,
+                                 std::size_t hash) const {
+    std::size_t mask = entries.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        const auto& entry = entries[i];
+        if (entry.state == State::EMPTY) return entries.size();
+        if (entry.state == State::FULL && entry.hash == hash &&
+            keysEqual(entry.key, key)) {
+            return i;
+        }
+    }
+}
+
+void HashTableValue::rehash(std::size_t capacity) {
+    auto old = std::move(entries);
+    entries.assign(capacity, Entry{});
+    used = count;
+    std::size_t mask = capacity - 1;
+    for (auto& entry : old) {
+        if (entry.state != State::FULL) continue;
+        std::size_t i = entry.hash & mask;
+        while (entries[i].state != State::EMPTY) i = (i + 1) & mask;
+        entries[i] = std::move(entry);
+    }
+}
+
+ValuePtr HashTableValue::get(const ValuePtr& key) const {
+    auto i = find(key, hashOf(key));
+    return i == entries.size() ? nullptr : entries[i].value;
+}
+
+void HashTableValue::set(const ValuePtr& key, ValuePtr value) {
+    auto hash = hashOf(key);
+    auto i = find(key, hash);
+    if (i != entries.size()) {
+        entries[i].value = std::move(value);
+        return;
+    }
+    // 占用（含已删除）超过一半时扩容，保证探测序列总能遇到空槽
+    if ((used + 1) * 2 > entries.size()) {
+        auto capacity = entries.size();
+        while ((count + 1) * 2 > capacity / 2) capacity *= 2;
+        rehash(std::max(capacity, MIN_CAPACITY));
+    }
+    std::size_t mask = entries.size() - 1;
+    i = hash & mask;
+    while (entries[i].state == State::FULL) i = (i + 1) & mask;
+    if (entries[i].state == State::EMPTY) ++used;
+    entries[i] = Entry{State::FULL, hash, key, std::move(value)};
+    ++count;
+}
+
+bool HashTableValue::remove(const ValuePtr& key) {
+    auto i = find(key, hashOf(key));
+    if (i == entries.size()) return false;
+    entries[i] = Entry{State::DELETED};
+    --count;
+    return true;
+}
+
+void HashTableValue::clear() {
+    entries.assign(MIN_CAPACITY, Entry{});
+    count = 0;
+    used = 0;
+}
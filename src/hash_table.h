@@ -0,0 +1,59 @@
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "value.h"
+
+// 开放定址（线性探测）的散列表，键按 eq? 或 equal? 比较
+class HashTableValue : public ContainerValue {
+public:
+    enum class Kind { EQ, EQUAL };
+
+private:
+    enum class State : std::uint8_t { EMPTY, FULL, DELETED };
+    struct Entry {
+        State state = State::EMPTY;
+        std::size_t hash = 0;
+        ValuePtr key;
+        ValuePtr value;
+    };
+
+    Kind kind;
+    std::vector<Entry> entries;  // 容量总是 2 的幂
+    std::size_t count = 0;
+    std::size_t used = 0;  // 已占用与已删除的槽位数，决定何时扩容
+
+    std::size_t hashOf(const ValuePtr& key) const;
+    bool keysEqual(const ValuePtr& a, const ValuePtr& b) const;
+    // 返回键所在的槽位，不存在时返回 entries.size()
+    std::size_t find(const ValuePtr& key, std::size_t hash) const;
+    void rehash(std::size_t capacity);
+
+public:
+    explicit HashTableValue(Kind kind = Kind::EQUAL);
+    ~HashTableValue() override = default;
+
+    Kind getKind() const {
+        return kind;
+    }
+    std::size_t size() const {
+        return count;
+    }
+    ValuePtr get(const ValuePtr& key) const;  // 不存在时返回空指针
+    void set(const ValuePtr& key, ValuePtr value);
+    bool remove(const ValuePtr& key);
+    void clear();
+
+    // 依次访问每个键值对
+    template <typename F>
+    void forEach(F f) const {
+        for (const auto& entry : entries) {
+            if (entry.state == State::FULL) f(entry.key, entry.value);
+        }
+    }
+};
+
+#endif
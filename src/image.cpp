@@ -0,0 +1,739 @@
+#include "image.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+#include "builtins.h"
+#include "error.h"
+#include "hash_table.h"
+#include "numeric.h"
+#include "pool.h"
+
+namespace {
+
+// 值的类型标记带有这一位时，读回后要登记序号，供后面的引用使用
+const std::uint8_t SHARED = 0x80;
+
+// 闭包所捕获环境的类型标记
+enum class EnvTag : std::uint8_t {
+    GLOBAL,
+    FRAME,
+    REFERENCE,
+};
+
+const char IMAGE_MAGIC[] = "MLISPIMG";  // 全局环境的映像
+const char FASL_MAGIC[] = "MLISPFSL";   // 单个值的二进制编码
+const std::uint8_t FORMAT_VERSION = 1;
+const std::size_t FILE_BUFFER_SIZE = 1 << 16;
+
+// 大整数按十进制原文写出。读回时先检查格式，损坏的内容不交给 parseInteger
+bool isIntegerText(std::string_view text) {
+    if (!text.empty() && (text.front() == '+' || text.front() == '-')) {
+        text.remove_prefix(1);
+    }
+    return !text.empty() &&
+           text.find_first_not_of("0123456789") == std::string_view::npos;
+}
+
+// 记下向外第 depth 层的帧要用到下标 index
+void require(std::map<std::size_t, std::size_t>& needs, std::size_t depth,
+             std::size_t index) {
+    auto [it, inserted] = needs.emplace(depth, index);
+    if (!inserted) it->second = std::max(it->second, index);
+}
+
+// 节点体在一个 frameSize 个槽位的新帧中求值：第 0 层的下标由新帧核对，
+// 其余各层向外移一层并入 outer
+void enterFrame(std::map<std::size_t, std::size_t>& outer,
+                const std::map<std::size_t, std::size_t>& inner,
+                std::size_t frameSize) {
+    for (auto [depth, index] : inner) {
+        if (depth == 0) {
+            if (index >= frameSize) throw LispError("Corrupt image");
+        } else {
+            require(outer, depth - 1, index);
+        }
+    }
+}
+
+}  // namespace
+
+ImageWriter::ImageWriter(std::ostream& out, const EvalEnv& global)
+    : out(out.rdbuf()), global(global) {
+    for (const auto& [name, info] : builtins) {
+        builtinNames.emplace(info.func, name);
+    }
+}
+
+void ImageWriter::writeByte(std::uint8_t byte) {
+    out->sputc(static_cast<char>(byte));
+}
+
+// 变长编码：每字节 7 位，最高位表示后面还有字节
+void ImageWriter::writeUnsigned(std::uint64_t value) {
+    while (value >= 0x80) {
+        writeByte(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    writeByte(static_cast<std::uint8_t>(value));
+}
+
+// 把符号交错映射到无符号数，绝对值小的负数也只占很少的字节
+void ImageWriter::writeSigned(std::int64_t value) {
+    auto bits = static_cast<std::uint64_t>(value);
+    writeUnsigned((bits << 1) ^ (value < 0 ? ~std::uint64_t{0} : 0));
+}
+
+void ImageWriter::writeDouble(double value) {
+    auto bits = std::bit_cast<std::uint64_t>(value);
+    for (int i = 0; i < 8; ++i) {
+        writeByte(static_cast<std::uint8_t>(bits >> (i * 8)));
+    }
+}
+
+void ImageWriter::writeString(std::string_view text) {
+    writeUnsigned(text.size());
+    out->sputn(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void ImageWriter::writeTag(ValueTag tag, bool shared) {
+    writeByte(static_cast<std::uint8_t>(tag) | (shared ? SHARED : 0));
+}
+
+bool ImageWriter::writeReference(const void* object) {
+    auto [it, inserted] = objects.emplace(object, objects.size());
+    if (inserted) return false;
+    writeTag(ValueTag::REFERENCE);
+    writeUnsigned(it->second);
+    return true;
+}
+
+void ImageWriter::writeSymbol(Symbol symbol) {
+    if (writeReference(symbol)) return;
+    writeTag(ValueTag::SYMBOL, true);
+    writeString(symbol->getName());
+}
+
+// 深层嵌套的数据用显式的栈按先序写出，不会递归耗尽栈
+void ImageWriter::writeValue(const ValuePtr& value) {
+    std::vector<const ValuePtr*> pending{&value};
+    while (!pending.empty()) {
+        const ValuePtr& next = *pending.back();
+        pending.pop_back();
+        writeOne(next, pending);
+    }
+}
+
+void ImageWriter::writeOne(const ValuePtr& value,
+                           std::vector<const ValuePtr*>& pending) {
+    if (!value) {
+        writeTag(ValueTag::NONE);
+        return;
+    }
+    switch (value->getType()) {
+        case ValueType::BOOLEAN:
+            writeTag(value->isTrue() ? ValueTag::TRUE_VALUE
+                                     : ValueTag::FALSE_VALUE);
+            return;
+        case ValueType::NIL: writeTag(ValueTag::NIL); return;
+        case ValueType::INTEGER:
+            writeTag(ValueTag::INTEGER);
+            writeSigned(static_cast<IntegerValue&>(*value).getValue());
+            return;
+        case ValueType::NUMERIC:
+            writeTag(ValueTag::NUMERIC);
+            writeDouble(value->asNumber());
+            return;
+        case ValueType::SYMBOL:
+            writeSymbol(static_cast<Symbol>(value.get()));
+            return;
+        default: break;
+    }
+    // 其余的值都有自己的身份。只被一处引用的对象不会再次遇到，不必登记，
+    // 其余的只写一次，之后写它的序号。pending 中存的是指向原指针的指针，
+    // 引用计数不受影响
+    bool shared = value.use_count() > 1;
+    if (shared && writeReference(value.get())) return;
+    auto mark = pending.size();
+    switch (value->getType()) {
+        case ValueType::BIGINT: {
+            const auto& bigint = static_cast<BigIntValue&>(*value).getValue();
+            writeTag(ValueTag::BIGINT, shared);
+            writeString(bigint.toString());
+            break;
+        }
+        case ValueType::STRING:
+            writeTag(ValueTag::STRING, shared);
+            writeString(static_cast<StringValue&>(*value).getValue());
+            break;
+        case ValueType::PAIR: {
+            // 先 car 后 cdr。长列表的 cdr 链每次只在栈上留一个位置
+            auto& pair = static_cast<const PairValue&>(*value);
+            writeTag(ValueTag::PAIR, shared);
+            pending.push_back(&pair.getLeft());
+            pending.push_back(&pair.getRight());
+            break;
+        }
+        case ValueType::VECTOR: {
+            const auto& values = static_cast<VectorValue&>(*value).getValues();
+            writeTag(ValueTag::VECTOR, shared);
+            writeUnsigned(values.size());
+            for (const auto& element : values) {
+                pending.push_back(&element);
+            }
+            break;
+        }
+        case ValueType::HASH_TABLE: {
+            auto& table = static_cast<HashTableValue&>(*value);
+            writeTag(ValueTag::HASH_TABLE, shared);
+            writeByte(table.getKind() == HashTableValue::Kind::EQ ? 0 : 1);
+            writeUnsigned(table.size());
+            table.forEach([&](const ValuePtr& key, const ValuePtr& entry) {
+                pending.push_back(&key);
+                pending.push_back(&entry);
+            });
+            break;
+        }
+        case ValueType::BUILTIN: {
+            auto func = static_cast<BuiltinProcValue&>(*value).getFunc();
+            auto it = builtinNames.find(func);
+            if (it == builtinNames.end()) {
+                throw LispError("Cannot serialize " + value->toString());
+            }
+            writeTag(ValueTag::BUILTIN, shared);
+            writeString(it->second);
+            break;
+        }
+        case ValueType::LAMBDA: {
+            auto& lambda = static_cast<LambdaValue&>(*value);
+            writeTag(ValueTag::LAMBDA, shared);
+            writeNode(lambda.getCode());
+            writeEnv(lambda.getEnv());
+            break;
+        }
+        default: throw LispError("Cannot serialize " + value->toString());
+    }
+    // 子值按顺序压入，倒过来才能按顺序弹出
+    std::reverse(pending.begin() + mark, pending.end());
+}
+
+void ImageWriter::writeEnv(const std::shared_ptr<EvalEnv>& env) {
+    if (env.get() == &global) {
+        writeByte(static_cast<std::uint8_t>(EnvTag::GLOBAL));
+        return;
+    }
+    if (!env || !env->getParent()) {
+        throw LispError("Cannot serialize a closure over another environment");
+    }
+    auto [it, inserted] = frames.emplace(env.get(), frames.size());
+    if (!inserted) {
+        writeByte(static_cast<std::uint8_t>(EnvTag::REFERENCE));
+        writeUnsigned(it->second);
+        return;
+    }
+    writeByte(static_cast<std::uint8_t>(EnvTag::FRAME));
+    writeUnsigned(env->slots.size());
+    writeEnv(env->getParent());
+    for (const auto& slot : env->slots) {
+        writeValue(slot);
+    }
+}
+
+void ImageWriter::writeNode(const NodePtr& node) {
+    if (!node) {
+        writeByte(static_cast<std::uint8_t>(NodeTag::NONE));
+        return;
+    }
+    auto [it, inserted] = nodes.emplace(node.get(), nodes.size());
+    if (!inserted) {
+        writeByte(static_cast<std::uint8_t>(NodeTag::REFERENCE));
+        writeUnsigned(it->second);
+        return;
+    }
+    node->serialize(*this);
+}
+
+void ImageWriter::writeNodes(const std::vector<NodePtr>& nodes) {
+    writeUnsigned(nodes.size());
+    for (const auto& node : nodes) {
+        writeNode(node);
+    }
+}
+
+ImageReader::ImageReader(std::istream& in, EvalEnv& global)
+    : in(in.rdbuf()), global(global), remaining(UINT64_MAX) {
+    // 能定位的输入先求出剩余长度，用来检查文件中记录的长度
+    auto here = this->in->pubseekoff(0, std::ios::cur, std::ios::in);
+    auto end = this->in->pubseekoff(0, std::ios::end, std::ios::in);
+    if (here != std::streampos(-1) && end != std::streampos(-1)) {
+        remaining = static_cast<std::uint64_t>(end - here);
+    }
+    this->in->pubseekpos(here, std::ios::in);
+}
+
+bool ImageReader::atEnd() {
+    return in->sgetc() == EOF;
+}
+
+std::uint8_t ImageReader::readByte() {
+    auto c = in->sbumpc();
+    if (c == EOF) throw LispError("Unexpected end of image");
+    --remaining;
+    return static_cast<std::uint8_t>(c);
+}
+
+std::uint64_t ImageReader::readUnsigned() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        auto byte = readByte();
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw LispError("Corrupt image");
+}
+
+std::uint64_t ImageReader::readLength() {
+    auto length = readUnsigned();
+    if (length > remaining) throw LispError("Corrupt image");
+    return length;
+}
+
+std::int64_t ImageReader::readSigned() {
+    auto bits = readUnsigned();
+    return static_cast<std::int64_t>((bits >> 1) ^ (~(bits & 1) + 1));
+}
+
+double ImageReader::readDouble() {
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits |= static_cast<std::uint64_t>(readByte()) << (i * 8);
+    }
+    return std::bit_cast<double>(bits);
+}
+
+std::string ImageReader::readString() {
+    auto size = readLength();
+    std::string text(size, '\0');
+    if (in->sgetn(text.data(), static_cast<std::streamsize>(size)) !=
+        static_cast<std::streamsize>(size)) {
+        throw LispError("Unexpected end of image");
+    }
+    remaining -= size;
+    return text;
+}
+
+Symbol ImageReader::readSymbol() {
+    auto value = readValue();
+    if (!value || !value->isSymbol()) throw LispError("Corrupt image");
+    return static_cast<Symbol>(value.get());
+}
+
+void ImageReader::remember(const ValuePtr& value, bool shared) {
+    if (shared) objects.push_back(value);
+}
+
+struct ImageReader::Partial {
+    ValuePtr value;        // 读完后交出的值：向量、散列表或序对链的表头
+    Value* current;        // 正在填充的向量、散列表或序对
+    std::uint64_t needed;  // 还要读的子值个数
+    ValuePtr key;          // 散列表中已读出、还在等待值的键
+
+    // 接收下一个子值，容器因此读完时返回 true
+    bool accept(ValuePtr child) {
+        switch (current->getType()) {
+            case ValueType::PAIR: {
+                auto pair = static_cast<PairValue*>(current);
+                if (needed == 2) {
+                    pair->setLeft(std::move(child));
+                } else {
+                    pair->setRight(std::move(child));
+                }
+                break;
+            }
+            case ValueType::VECTOR:
+                static_cast<VectorValue*>(current)->getValues().push_back(
+                    std::move(child));
+                break;
+            default:
+                // 散列表的子值是交替的键和值
+                if (needed % 2 == 0) {
+                    key = std::move(child);
+                } else {
+                    static_cast<HashTableValue*>(current)->set(
+                        key, std::move(child));
+                    key = nullptr;
+                }
+                break;
+        }
+        return --needed == 0;
+    }
+};
+
+// 深层嵌套的数据用显式的栈读回，不会递归耗尽栈
+ValuePtr ImageReader::readValue() {
+    std::vector<Partial> pending;
+    while (true) {
+        ValuePtr value;
+        if (!readOne(value, pending)) continue;
+        // 读完的值交给栈顶的容器，容器因此读完时再向上交
+        while (true) {
+            if (pending.empty()) return value;
+            auto& top = pending.back();
+            if (!top.accept(std::move(value))) break;
+            value = std::move(top.value);
+            pending.pop_back();
+        }
+    }
+}
+
+bool ImageReader::readOne(ValuePtr& value, std::vector<Partial>& pending) {
+    auto byte = readByte();
+    bool shared = byte & SHARED;
+    switch (static_cast<ValueTag>(byte & ~SHARED)) {
+        case ValueTag::NONE: value = nullptr; return true;
+        case ValueTag::REFERENCE: {
+            auto index = readUnsigned();
+            if (index >= objects.size() || !objects[index]) {
+                throw LispError("Corrupt image");
+            }
+            value = objects[index];
+            return true;
+        }
+        case ValueTag::FALSE_VALUE:
+            value = BooleanValue::of(false);
+            return true;
+        case ValueTag::TRUE_VALUE:
+            value = BooleanValue::of(true);
+            return true;
+        case ValueTag::NIL:
+            value = NilValue::instance();
+            return true;
+        case ValueTag::INTEGER:
+            value = IntegerValue::of(readSigned());
+            return true;
+        case ValueTag::NUMERIC:
+            value = NumericValue::of(readDouble());
+            return true;
+        case ValueTag::SYMBOL:
+            value = SymbolValue::intern(readString());
+            remember(value, shared);
+            return true;
+        case ValueTag::BIGINT: {
+            auto text = readString();
+            if (!isIntegerText(text)) throw LispError("Corrupt image");
+            value = parseInteger(text);
+            remember(value, shared);
+            return true;
+        }
+        case ValueTag::STRING:
+            value = std::make_shared<StringValue>(readString());
+            remember(value, shared);
+            return true;
+        case ValueTag::PAIR: {
+            // 先登记再读 car，序对被自己的 car 引用时才能找到
+            auto pair = makePooled<PairValue>(NilValue::instance(),
+                                              NilValue::instance());
+            remember(pair, shared);
+            auto top = pending.empty() ? nullptr : &pending.back();
+            if (top && top->current->isPair() && top->needed == 1) {
+                // cdr 又是序对时接在链上，长列表只占一个栈位
+                static_cast<PairValue*>(top->current)->setRight(pair);
+                top->current = pair.get();
+                top->needed = 2;
+            } else {
+                auto current = pair.get();
+                pending.push_back({std::move(pair), current, 2});
+            }
+            return false;
+        }
+        case ValueTag::VECTOR: {
+            auto vector =
+                std::make_shared<VectorValue>(std::vector<ValuePtr>{});
+            remember(vector, shared);
+            auto size = readLength();
+            if (size == 0) {
+                value = std::move(vector);
+                return true;
+            }
+            vector->getValues().reserve(size);
+            auto current = vector.get();
+            pending.push_back({std::move(vector), current, size});
+            return false;
+        }
+        case ValueTag::HASH_TABLE: {
+            auto kind = readByte() == 0 ? HashTableValue::Kind::EQ
+                                        : HashTableValue::Kind::EQUAL;
+            auto table = std::make_shared<HashTableValue>(kind);
+            remember(table, shared);
+            auto size = readLength();
+            if (size == 0) {
+                value = std::move(table);
+                return true;
+            }
+            auto current = table.get();
+            pending.push_back({std::move(table), current, size * 2});
+            return false;
+        }
+        case ValueTag::BUILTIN: {
+            auto name = SymbolValue::intern(readString());
+            auto& table = *EvalEnv::builtinEnv()->symbolTable;
+            auto it = table.find(name.get());
+            if (it == table.end()) throw LispError("Corrupt image");
+            remember(it->second, shared);
+            value = it->second;
+            return true;
+        }
+        case ValueTag::LAMBDA: {
+            // 先登记闭包再读它的环境，环境中引用它自己时才能找到
+            auto lambda = std::make_shared<LambdaValue>(
+                nullptr, nullptr, global.engine == EvalEngine::BYTECODE);
+            remember(lambda, shared);
+            SlotNeeds needs;
+            lambda->code =
+                std::dynamic_pointer_cast<const LambdaNode>(readNode(needs));
+            if (!lambda->code) throw LispError("Corrupt image");
+            lambda->definingEnv = readEnv();
+            // 代码引用的外层槽位都要落在捕获的各层帧内
+            const EvalEnv* env = lambda->definingEnv.get();
+            std::size_t depth = 0;
+            for (auto [needDepth, index] : needs) {
+                for (; env && depth < needDepth; ++depth) {
+                    env = env->parent.get();
+                }
+                if (!env || index >= env->slots.size()) {
+                    throw LispError("Corrupt image");
+                }
+            }
+            value = std::move(lambda);
+            return true;
+        }
+    }
+    throw LispError("Corrupt image");
+}
+
+std::shared_ptr<EvalEnv> ImageReader::readEnv() {
+    auto tag = static_cast<EnvTag>(readByte());
+    if (tag == EnvTag::GLOBAL) {
+        return global.shared_from_this();
+    } else if (tag == EnvTag::REFERENCE) {
+        auto index = readUnsigned();
+        // 还在读外层链的帧没有 parent，引用它会让外层链成环
+        if (index >= frames.size() || !frames[index]->parent) {
+            throw LispError("Corrupt image");
+        }
+        return frames[index];
+    } else if (tag != EnvTag::FRAME) {
+        throw LispError("Corrupt image");
+    }
+    auto size = readLength();
+    auto frame = EvalEnv::createFrame(nullptr, size);
+    frames.push_back(frame);
+    frame->parent = readEnv();
+    frame->global = frame->parent->global;
+    frame->engine = frame->parent->engine;
+    for (auto& slot : frame->slots) {
+        slot = readValue();
+    }
+    return frame;
+}
+
+NodePtr ImageReader::readNode(SlotNeeds& needs, bool optional) {
+    auto tag = static_cast<NodeTag>(readByte());
+    if (tag == NodeTag::NONE) {
+        if (!optional) throw LispError("Corrupt image");
+        return nullptr;
+    } else if (tag == NodeTag::REFERENCE) {
+        auto index = readUnsigned();
+        if (index >= nodes.size() || !nodes[index]) {
+            throw LispError("Corrupt image");
+        }
+        for (auto [depth, slot] : nodeNeeds[index]) {
+            require(needs, depth, slot);
+        }
+        return nodes[index];
+    }
+    auto index = nodes.size();
+    nodes.emplace_back();
+    nodeNeeds.emplace_back();
+    SlotNeeds own;
+    auto node = readNodeBody(tag, own);
+    for (auto [depth, slot] : own) {
+        require(needs, depth, slot);
+    }
+    nodes[index] = node;
+    nodeNeeds[index] = std::move(own);
+    return node;
+}
+
+std::vector<NodePtr> ImageReader::readNodes(SlotNeeds& needs) {
+    auto size = readLength();
+    std::vector<NodePtr> result;
+    result.reserve(size);
+    for (std::uint64_t i = 0; i < size; ++i) {
+        result.push_back(readNode(needs));
+    }
+    return result;
+}
+
+// 构造函数实参的求值顺序不确定，各字段先按写出的顺序读到局部变量中
+NodePtr ImageReader::readNodeBody(NodeTag tag, SlotNeeds& needs) {
+    switch (tag) {
+        case NodeTag::CONSTANT:
+            return std::make_shared<ConstantNode>(readValue());
+        case NodeTag::GLOBAL_VARIABLE:
+            return std::make_shared<GlobalVariableNode>(readSymbol());
+        case NodeTag::LOCAL_VARIABLE: {
+            auto name = readSymbol();
+            auto depth = readUnsigned();
+            auto index = readUnsigned();
+            require(needs, depth, index);
+            return std::make_shared<LocalVariableNode>(name, depth, index);
+        }
+        case NodeTag::GLOBAL_DEFINE: {
+            auto name = readSymbol();
+            auto value = readNode(needs);
+            return std::make_shared<GlobalDefineNode>(name, std::move(value));
+        }
+        case NodeTag::LOCAL_DEFINE: {
+            auto index = readUnsigned();
+            require(needs, 0, index);
+            auto value = readNode(needs);
+            return std::make_shared<LocalDefineNode>(index, std::move(value));
+        }
+        case NodeTag::LAMBDA: {
+            std::vector<Symbol> params(readLength());
+            for (auto& param : params) {
+                param = readSymbol();
+            }
+            // 帧中除参数外的槽位都属于内部定义，各占至少一个字节
+            auto frameSize = readLength();
+            if (frameSize < params.size()) throw LispError("Corrupt image");
+            SlotNeeds inner;
+            auto body = readNodes(inner);
+            enterFrame(needs, inner, frameSize);
+            return std::make_shared<LambdaNode>(params, frameSize,
+                                                std::move(body));
+        }
+        case NodeTag::IF: {
+            auto condition = readNode(needs);
+            auto consequent = readNode(needs);
+            auto alternative = readNode(needs, true);
+            return std::make_shared<IfNode>(std::move(condition),
+                                            std::move(consequent),
+                                            std::move(alternative));
+        }
+        case NodeTag::AND: return std::make_shared<AndNode>(readNodes(needs));
+        case NodeTag::OR: return std::make_shared<OrNode>(readNodes(needs));
+        case NodeTag::COND: {
+            std::vector<CondClause> clauses(readLength());
+            for (auto& clause : clauses) {
+                clause.test = readNode(needs, true);
+                clause.body = readNodes(needs);
+            }
+            return std::make_shared<CondNode>(std::move(clauses));
+        }
+        case NodeTag::BEGIN:
+            return std::make_shared<BeginNode>(readNodes(needs));
+        case NodeTag::LET: {
+            auto inits = readNodes(needs);
+            auto frameSize = readLength();
+            if (frameSize < inits.size()) throw LispError("Corrupt image");
+            SlotNeeds inner;
+            auto body = readNodes(inner);
+            enterFrame(needs, inner, frameSize);
+            return std::make_shared<LetNode>(std::move(inits), frameSize,
+                                             std::move(body));
+        }
+        case NodeTag::QUASI_LIST:
+            return std::make_shared<QuasiListNode>(readNodes(needs));
+        case NodeTag::CALL: {
+            auto proc = readNode(needs);
+            auto args = readNodes(needs);
+            return std::make_shared<CallNode>(std::move(proc), std::move(args));
+        }
+        default: throw LispError("Corrupt image");
+    }
+}
+
+// 以较大的缓冲区打开文件并写出文件头，再由 body 写出内容
+template <typename F>
+static void writeFile(const std::string& path, EvalEnv& global,
+                      std::string_view magic, F body) {
+    std::vector<char> buffer(FILE_BUFFER_SIZE);
+    std::ofstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw LispError("Unable to open file " + path);
+    }
+    ImageWriter writer(file, global);
+    for (char c : magic) {
+        writer.writeByte(static_cast<std::uint8_t>(c));
+    }
+    writer.writeByte(FORMAT_VERSION);
+    body(writer);
+    if (!file.flush()) {
+        throw LispError("Unable to write file " + path);
+    }
+}
+
+// 打开文件并检查文件头，再由 body 读出内容
+template <typename F>
+static void readFile(const std::string& path, EvalEnv& global,
+                     std::string_view magic, F body) {
+    std::vector<char> buffer(FILE_BUFFER_SIZE);
+    std::ifstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw LispError("Unable to open file " + path);
+    }
+    ImageReader reader(file, global);
+    for (char c : magic) {
+        if (reader.atEnd() ||
+            reader.readByte() != static_cast<std::uint8_t>(c)) {
+            throw LispError(path + " is not in the expected format");
+        }
+    }
+    if (reader.readByte() != FORMAT_VERSION) {
+        throw LispError(path + " has an unsupported format version");
+    }
+    body(reader);
+}
+
+void dumpImage(const std::string& path, EvalEnv& global) {
+    writeFile(path, global, IMAGE_MAGIC, [&](ImageWriter& writer) {
+        writer.writeUnsigned(global.symbolTable->size());
+        for (const auto& [name, value] : *global.symbolTable) {
+            writer.writeSymbol(name);
+            writer.writeValue(value);
+        }
+    });
+}
+
+void loadImage(const std::string& path, EvalEnv& global) {
+    readFile(path, global, IMAGE_MAGIC, [&](ImageReader& reader) {
+        auto count = reader.readLength();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            auto name = reader.readSymbol();
+            global.defineGlobal(name, reader.readValue());
+        }
+    });
+}
+
+void writeFasl(const std::string& path, const ValuePtr& value,
+               EvalEnv& global) {
+    writeFile(path, global, FASL_MAGIC,
+              [&](ImageWriter& writer) { writer.writeValue(value); });
+}
+
+ValuePtr readFasl(const std::string& path, EvalEnv& global) {
+    ValuePtr result;
+    readFile(path, global, FASL_MAGIC,
+             [&](ImageReader& reader) { result = reader.readValue(); });
+    if (!result) throw LispError(path + " is corrupt");
+    return result;
+}
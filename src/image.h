@@ -0,0 +1,142 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "eval_env.h"
+#include "node.h"
+#include "value.h"
+
+// 值在映像中的类型标记
+enum class ValueTag : std::uint8_t {
+    NONE,  // 尚未赋值的槽位
+    REFERENCE,
+    FALSE_VALUE,
+    TRUE_VALUE,
+    NIL,
+    INTEGER,
+    BIGINT,
+    NUMERIC,
+    STRING,
+    SYMBOL,
+    PAIR,
+    VECTOR,
+    HASH_TABLE,
+    BUILTIN,
+    LAMBDA,
+};
+
+// 已分析节点在映像中的类型标记
+enum class NodeTag : std::uint8_t {
+    NONE,  // 空节点，如没有 else 分支的 if
+    REFERENCE,
+    CONSTANT,
+    GLOBAL_VARIABLE,
+    LOCAL_VARIABLE,
+    GLOBAL_DEFINE,
+    LOCAL_DEFINE,
+    LAMBDA,
+    IF,
+    AND,
+    OR,
+    COND,
+    BEGIN,
+    LET,
+    QUASI_LIST,
+    CALL,
+};
+
+// 把值与已分析的代码写成紧凑的二进制编码。每个对象（序对、字符串、
+// 符号、闭包、环境帧、节点）只写一次，再次出现时写它的序号，
+// 因此共享的子结构和环状引用读回后保持原样
+class ImageWriter {
+    std::streambuf* out;
+    const EvalEnv& global;  // 闭包捕获全局环境时只写一个标记
+    std::unordered_map<const void*, std::uint32_t> objects;
+    std::unordered_map<const EvalEnv*, std::uint32_t> frames;
+    std::unordered_map<const Node*, std::uint32_t> nodes;
+    std::unordered_map<BuiltinFuncType*, std::string> builtinNames;
+
+    void writeTag(ValueTag tag, bool shared = false);
+    // 已写过的对象写出引用并返回 true，否则为它分配序号
+    bool writeReference(const void* object);
+    // 写出一个值本身；容器的子值按写出顺序的逆序压入 pending
+    void writeOne(const ValuePtr& value,
+                  std::vector<const ValuePtr*>& pending);
+    void writeEnv(const std::shared_ptr<EvalEnv>& env);
+
+public:
+    ImageWriter(std::ostream& out, const EvalEnv& global);
+
+    void writeByte(std::uint8_t byte);
+    void writeUnsigned(std::uint64_t value);
+    void writeSigned(std::int64_t value);
+    void writeDouble(double value);
+    void writeString(std::string_view text);
+    void writeSymbol(Symbol symbol);
+    void writeValue(const ValuePtr& value);
+    void writeNode(const NodePtr& node);
+    void writeNodes(const std::vector<NodePtr>& nodes);
+};
+
+// 按 ImageWriter 的编码读回值与代码，闭包绑定到给定的全局环境
+class ImageReader {
+    struct Partial;  // 已经开始、还在等待子值的容器
+    // 代码中局部变量用到的槽位：向外第 depth 层的帧要用到的最大下标。
+    // 读回的闭包要先核对这些下标都落在帧内，损坏的文件才不会越界访问
+    using SlotNeeds = std::map<std::size_t, std::size_t>;
+
+    std::streambuf* in;
+    EvalEnv& global;
+    std::uint64_t remaining;  // 输入中还没读的字节数
+    std::vector<ValuePtr> objects;
+    std::vector<std::shared_ptr<EvalEnv>> frames;
+    std::vector<NodePtr> nodes;
+    std::vector<SlotNeeds> nodeNeeds;  // 与 nodes 一一对应
+
+    std::shared_ptr<EvalEnv> readEnv();
+    void remember(const ValuePtr& value, bool shared);
+    // 读出一个值的开头。读完整个值时存入 value 并返回 true；
+    // 读到容器时把它压入 pending 等待子值，返回 false
+    bool readOne(ValuePtr& value, std::vector<Partial>& pending);
+    // 读出节点，并把它用到的槽位并入 needs（以节点所在的帧为第 0 层）。
+    // 只有 optional 为真时才接受空节点
+    NodePtr readNode(SlotNeeds& needs, bool optional = false);
+    std::vector<NodePtr> readNodes(SlotNeeds& needs);
+    NodePtr readNodeBody(NodeTag tag, SlotNeeds& needs);
+
+public:
+    ImageReader(std::istream& in, EvalEnv& global);
+
+    bool atEnd();
+    std::uint8_t readByte();
+    std::uint64_t readUnsigned();
+    // 读出随后的元素个数或字节数。每个元素至少占一个字节，
+    // 超出剩余输入的长度说明文件已损坏，在分配内存之前就报错
+    std::uint64_t readLength();
+    std::int64_t readSigned();
+    double readDouble();
+    std::string readString();
+    Symbol readSymbol();
+    ValuePtr readValue();
+};
+
+// 把全局环境中用户定义的绑定写成映像文件
+void dumpImage(const std::string& path, EvalEnv& global);
+// 读回映像文件中的绑定并加入全局环境，格式不符时抛出 LispError
+void loadImage(const std::string& path, EvalEnv& global);
+// 把一个值（连同它引用的全部对象）写成二进制文件
+void writeFasl(const std::string& path, const ValuePtr& value,
+               EvalEnv& global);
+// 读回 writeFasl 写出的值，其中的闭包绑定到 global
+ValuePtr readFasl(const std::string& path, EvalEnv& global);
+
+#endif
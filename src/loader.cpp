@@ -0,0 +1,26 @@
+#include "loader.h"
+
+#include <fstream>
+
+#include "error.h"
+#include "parse.h"
+#include "tokenizer.h"
+#include "value.h"
+
+ValuePtr loadStream(std::istream& input, EvalEnv& env) {
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    ValuePtr result = NilValue::instance();
+    while (!parser.atEnd()) {
+        result = env.eval(parser.parse());
+    }
+    return result;
+}
+
+ValuePtr loadFile(const std::string& path, EvalEnv& env) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw LispError("Unable to open file " + path);
+    }
+    return loadStream(file, env);
+}
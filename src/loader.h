@@ -0,0 +1,14 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <istream>
+#include <string>
+
+#include "eval_env.h"
+
+// 依次读取并求值输入中的全部顶层表达式，返回最后一个表达式的值
+ValuePtr loadStream(std::istream& input, EvalEnv& env);
+// 打开并执行脚本文件，文件无法打开时抛出 LispError
+ValuePtr loadFile(const std::string& path, EvalEnv& env);
+
+#endif
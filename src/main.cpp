@@ -4,67 +4,89 @@
 #include <string>
 
 #include "eval_env.h"
+#include "image.h"
+#include "loader.h"
 #include "parse.h"
+#include "port.h"
 #include "rjsj_test.hpp"
 #include "tokenizer.h"
 #include "value.h"
 
+EvalEngine engine = EvalEngine::TREE;  // 由命令行 --vm 切换到字节码虚拟机
+
 struct TestCtx {
     std::shared_ptr<EvalEnv> env;
 
-    TestCtx() : env(EvalEnv::createGlobal()) {}
+    TestCtx() : env(EvalEnv::createGlobal(engine)) {}
 
     std::string eval(std::string input) {
-        auto tokens = Tokenizer::tokenize(input);
-        Parser parser(std::move(tokens));
+        std::istringstream stream(input);
+        Tokenizer tokenizer(stream);
+        Parser parser(tokenizer);
         auto value = parser.parse();
         auto result = env->eval(std::move(value));
+        standardOutputPort()->flush();  // display 的输出紧跟在输入之后
         return result->toString();
     }
 };
-bool fileMode = false;
 int main(int argc, char* argv[]) {
-    RJSJ_TEST(TestCtx, Lv2, Lv3, Lv4, Lv5, Lv5Extra, Lv6, Lv7, Lv7Lib, Sicp);
+    const char* fileName = nullptr;
+    const char* imageName = nullptr;  // --image：启动时先读入的映像
+    const char* dumpName = nullptr;   // --dump-image：结束时写出的映像
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--vm") {
+            engine = EvalEngine::BYTECODE;
+        } else if (arg == "--image" && i + 1 < argc) {
+            imageName = argv[++i];
+        } else if (arg == "--dump-image" && i + 1 < argc) {
+            dumpName = argv[++i];
+        } else {
+            fileName = argv[i];
+        }
+    }
+    auto env = EvalEnv::createGlobal(engine);
+    if (fileName || imageName || dumpName) {
+        // 给出脚本文件时执行脚本，遇到错误即停止；只给出映像时进入交互模式
+        try {
+            if (imageName) loadImage(imageName, *env);
+            if (fileName) loadFile(fileName, *env);
+            if (dumpName) dumpImage(dumpName, *env);
+            standardOutputPort()->flush();
+        } catch (std::runtime_error& e) {
+            standardOutputPort()->flush();
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        if (fileName || dumpName) return 0;
+    } else {
+        RJSJ_TEST(TestCtx, Lv2, Lv3, Lv4, Lv5, Lv5Extra, Lv6, Lv7, Lv7Lib,
+                  Sicp, Bignum, HashTable, Vector, Load, Fasl, Port, Gc);
+    }
     /*ValuePtr a = std::make_shared<PairValue>(
         std::make_shared<SymbolValue>("quote"),
         std::make_shared<PairValue>(std::make_shared<NumericValue>(42),
                                     std::make_shared<NilValue>()));
     std::cout << a->toString() << std::endl;*/
-    EvalEnv env(nullptr);
-    std::ifstream file;
-    if (argc > 1) {
-        fileMode = true;
-        file.open(argv[1]);
-        if (!file.is_open()) {
-            std::cerr << "Error: Unable to open file " << argv[1] << std::endl;
-            return 1;
-        } else
-            std::cout << "File opened successfully" << std::endl;
-    }
     while (true) {
         try {
+            std::cout << ">>> ";
             std::string line;
-            if (fileMode) {
-                std::getline(file, line);
-            } else {
-                std::cout << ">>> ";
-
-                std::getline(std::cin, line);
-                if (std::cin.eof()) {
-                    std::exit(0);
-                }
+            std::getline(std::cin, line);
+            if (std::cin.eof()) {
+                std::exit(0);
             }
-            auto tokens = Tokenizer::tokenize(line);
-            Parser parser(std::move(tokens));  // TokenPtr 不支持复制
+            std::istringstream stream(line);
+            Tokenizer tokenizer(stream);
+            Parser parser(tokenizer);
             auto value = parser.parse();
-            auto result = env.eval(std::move(value));
-            if (!fileMode) {
-                std::cout << result->toString() << std::endl;  // test3
-                for (auto& token : tokens) {
-                    std::cout << *token << std::endl;
-                }
-            }
+            auto result = env->eval(std::move(value));
+            auto& port = *standardOutputPort();
+            port.print(*result);
+            port.write('\n');
+            port.flush();
         } catch (std::runtime_error& e) {
+            standardOutputPort()->flush();
             std::cerr << "Error: " << e.what() << std::endl;
         }
     }
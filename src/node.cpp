@@ -0,0 +1,432 @@
+#include "node.h"
+
+#include <array>
+#include <span>
+
+#include "bytecode.h"
+#include "error.h"
+#include "eval_env.h"
+#include "image.h"
+#include "pool.h"
+
+// 调用内置过程时，不超过这么多个实参直接放在 C++ 栈上
+static constexpr std::size_t INLINE_ARGS = 4;
+
+ValuePtr evalSequence(const std::vector<NodePtr>& body, EvalEnv& env) {
+    ValuePtr lastEvalResult = NilValue::instance();
+    for (const auto& node : body) {
+        lastEvalResult = node->eval(env);
+    }
+    return lastEvalResult;  // 返回最后一个表达式的求值结果
+}
+
+ValuePtr evalSequenceTail(const std::vector<NodePtr>& body, EvalEnv& env,
+                          TailCall& call) {
+    if (body.empty()) return NilValue::instance();
+    for (std::size_t i = 0; i + 1 < body.size(); ++i) {
+        body[i]->eval(env);
+    }
+    return body.back()->evalTail(env, call);
+}
+
+ValuePtr ConstantNode::eval(EvalEnv& env) const {
+    return value;
+}
+
+ValuePtr GlobalVariableNode::eval(EvalEnv& env) const {
+    return env.getGlobal().lookupGlobal(name, cache);
+}
+
+ValuePtr LocalVariableNode::eval(EvalEnv& env) const {
+    auto& value = env.ancestor(depth).slots[index];
+    if (!value) {
+        throw LispError("Variable " + name->getName() + " not defined.");
+    }
+    return value;
+}
+
+ValuePtr GlobalDefineNode::eval(EvalEnv& env) const {
+    env.getGlobal().defineGlobal(name, value->eval(env));
+    return NilValue::instance();  // 定义操作成功后返回Nil
+}
+
+ValuePtr LocalDefineNode::eval(EvalEnv& env) const {
+    env.slots[index] = value->eval(env);
+    return NilValue::instance();
+}
+
+ValuePtr LambdaNode::eval(EvalEnv& env) const {
+    return std::make_shared<LambdaValue>(shared_from_this(),
+                                         env.shared_from_this());
+}
+
+std::shared_ptr<EvalEnv> LambdaNode::bind(
+    EvalEnv& definingEnv, std::span<const ValuePtr> args) const {
+    if (params.size() != args.size()) {
+        throw LispError("Parameter and argument counts do not match.");
+    }
+    return definingEnv.createChild(frameSize, args);
+}
+
+// 非尾位置求值：执行完尾位置上留下的调用
+static ValuePtr evalComplete(const Node& node, EvalEnv& env) {
+    TailCall call;
+    ValuePtr result = node.evalTail(env, call);
+    return result ? result : call.proc->apply(call.args);
+}
+
+ValuePtr IfNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr IfNode::evalTail(EvalEnv& env, TailCall& call) const {
+    ValuePtr result = condition->eval(env);
+    if (result->isTrue()) {
+        return consequent->evalTail(env, call);  // 真分支
+    } else if (alternative) {
+        return alternative->evalTail(env, call);
+    } else {
+        return NilValue::instance();
+    }
+}
+
+ValuePtr AndNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr AndNode::evalTail(EvalEnv& env, TailCall& call) const {
+    if (operands.empty()) return BooleanValue::of(true);
+    for (std::size_t i = 0; i + 1 < operands.size(); ++i) {
+        ValuePtr result = operands[i]->eval(env);
+        if (!result->isTrue()) {
+            return result;
+        }
+    }
+    // 若全部为真，则返回最后一个表达式的值
+    return operands.back()->evalTail(env, call);
+}
+
+ValuePtr OrNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr OrNode::evalTail(EvalEnv& env, TailCall& call) const {
+    if (operands.empty()) return BooleanValue::of(false);
+    for (std::size_t i = 0; i + 1 < operands.size(); ++i) {
+        ValuePtr result = operands[i]->eval(env);
+        if (result->isTrue()) {
+            return result;
+        }
+    }
+    return operands.back()->evalTail(env, call);
+}
+
+ValuePtr CondNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr CondNode::evalTail(EvalEnv& env, TailCall& call) const {
+    for (const auto& clause : clauses) {
+        ValuePtr testResult;
+        if (clause.test) {
+            testResult = clause.test->eval(env);
+            if (!testResult->isTrue()) continue;
+        }
+        if (clause.body.empty()) {
+            // 如果只有条件，没有表达式，则返回条件的求值结果
+            return testResult;
+        }
+        return evalSequenceTail(clause.body, env, call);
+    }
+    return NilValue::instance();  // 如果所有条件都不满足，返回Nil
+}
+
+ValuePtr BeginNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr BeginNode::evalTail(EvalEnv& env, TailCall& call) const {
+    return evalSequenceTail(body, env, call);
+}
+
+ValuePtr LetNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr LetNode::evalTail(EvalEnv& env, TailCall& call) const {
+    std::vector<ValuePtr> values;
+    values.reserve(inits.size());
+    for (const auto& init : inits) {
+        values.push_back(init->eval(env));
+    }
+    auto letEnv = env.createChild(frameSize, values);
+    return evalSequenceTail(body, *letEnv, call);
+}
+
+ValuePtr QuasiListNode::eval(EvalEnv& env) const {
+    std::vector<ValuePtr> values;
+    values.reserve(elements.size());
+    for (const auto& element : elements) {
+        values.push_back(element->eval(env));
+    }
+    ValuePtr result = NilValue::instance();
+    for (auto it = values.rbegin(); it != values.rend(); ++it) {
+        result = makePooled<PairValue>(*it, result);
+    }
+    return result;
+}
+
+ValuePtr CallNode::eval(EvalEnv& env) const {
+    return evalComplete(*this, env);
+}
+
+ValuePtr CallNode::evalTail(EvalEnv& env, TailCall& call) const {
+    ValuePtr procValue = proc->eval(env);
+    if (procValue->getType() == ValueType::LAMBDA &&
+        !static_cast<LambdaValue&>(*procValue).isCompiled()) {
+        // 交给外层的 LambdaValue::apply 循环执行，不再加深 C++ 栈
+        call.args.clear();
+        call.args.reserve(args.size());
+        for (const auto& arg : args) {
+            call.args.push_back(arg->eval(env));
+        }
+        call.proc =
+            std::static_pointer_cast<LambdaValue>(std::move(procValue));
+        return nullptr;
+    }
+    // 其余调用的实参不多时放在 C++ 栈上，调用内置过程不分配堆内存
+    if (args.size() <= INLINE_ARGS) {
+        std::array<ValuePtr, INLINE_ARGS> argValues;
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            argValues[i] = args[i]->eval(env);
+        }
+        return env.apply(procValue,
+                         std::span(argValues.data(), args.size()));
+    }
+    std::vector<ValuePtr> argValues;
+    argValues.reserve(args.size());
+    for (const auto& arg : args) {
+        argValues.push_back(arg->eval(env));
+    }
+    return env.apply(procValue, argValues);
+}
+
+void ConstantNode::compile(Compiler& compiler, bool tail) const {
+    compiler.emit(OpCode::CONST, compiler.addConstant(value));
+}
+
+void GlobalVariableNode::compile(Compiler& compiler, bool tail) const {
+    compiler.emit(OpCode::LOAD_GLOBAL, compiler.addName(name));
+}
+
+void LocalVariableNode::compile(Compiler& compiler, bool tail) const {
+    auto at = compiler.emit(OpCode::LOAD_LOCAL, index, depth);
+    compiler.nameLocal(at, name);
+}
+
+void GlobalDefineNode::compile(Compiler& compiler, bool tail) const {
+    value->compile(compiler, false);
+    compiler.emit(OpCode::DEFINE_GLOBAL, compiler.addName(name));
+}
+
+void LocalDefineNode::compile(Compiler& compiler, bool tail) const {
+    value->compile(compiler, false);
+    compiler.emit(OpCode::DEFINE_LOCAL, index);
+}
+
+void LambdaNode::compile(Compiler& compiler, bool tail) const {
+    compiler.emit(OpCode::CLOSURE, compiler.addLambda(shared_from_this()));
+}
+
+const std::shared_ptr<const Code>& LambdaNode::getCompiled() const {
+    if (!compiled) {
+        compiled = Compiler::compileBody(body);
+    }
+    return compiled;
+}
+
+void IfNode::compile(Compiler& compiler, bool tail) const {
+    condition->compile(compiler, false);
+    auto toElse = compiler.emit(OpCode::JUMP_IF_FALSE);
+    consequent->compile(compiler, tail);
+    auto toEnd = compiler.emit(OpCode::JUMP);
+    compiler.patch(toElse);
+    if (alternative) {
+        alternative->compile(compiler, tail);
+    } else {
+        compiler.emit(OpCode::CONST,
+                      compiler.addConstant(NilValue::instance()));
+    }
+    compiler.patch(toEnd);
+}
+
+void AndNode::compile(Compiler& compiler, bool tail) const {
+    if (operands.empty()) {
+        compiler.emit(OpCode::CONST, compiler.addConstant(
+                                         BooleanValue::of(true)));
+        return;
+    }
+    std::vector<std::size_t> toEnd;
+    for (std::size_t i = 0; i + 1 < operands.size(); ++i) {
+        operands[i]->compile(compiler, false);
+        toEnd.push_back(compiler.emit(OpCode::JUMP_IF_FALSE_KEEP));
+    }
+    operands.back()->compile(compiler, tail);
+    for (auto at : toEnd) compiler.patch(at);
+}
+
+void OrNode::compile(Compiler& compiler, bool tail) const {
+    if (operands.empty()) {
+        compiler.emit(OpCode::CONST,
+                      compiler.addConstant(BooleanValue::of(false)));
+        return;
+    }
+    std::vector<std::size_t> toEnd;
+    for (std::size_t i = 0; i + 1 < operands.size(); ++i) {
+        operands[i]->compile(compiler, false);
+        toEnd.push_back(compiler.emit(OpCode::JUMP_IF_TRUE_KEEP));
+    }
+    // 前面的操作数都为假时结果就是最后一个的值，它在尾位置上
+    operands.back()->compile(compiler, tail);
+    for (auto at : toEnd) compiler.patch(at);
+}
+
+void CondNode::compile(Compiler& compiler, bool tail) const {
+    std::vector<std::size_t> toEnd;
+    for (const auto& clause : clauses) {
+        if (!clause.test) {
+            compiler.compileSequence(clause.body, tail);
+            toEnd.push_back(compiler.emit(OpCode::JUMP));
+            continue;
+        }
+        clause.test->compile(compiler, false);
+        if (clause.body.empty()) {
+            toEnd.push_back(compiler.emit(OpCode::JUMP_IF_TRUE_KEEP));
+            continue;
+        }
+        auto toNext = compiler.emit(OpCode::JUMP_IF_FALSE);
+        compiler.compileSequence(clause.body, tail);
+        toEnd.push_back(compiler.emit(OpCode::JUMP));
+        compiler.patch(toNext);
+    }
+    compiler.emit(OpCode::CONST,
+                  compiler.addConstant(NilValue::instance()));
+    for (auto at : toEnd) compiler.patch(at);
+}
+
+void BeginNode::compile(Compiler& compiler, bool tail) const {
+    compiler.compileSequence(body, tail);
+}
+
+void LetNode::compile(Compiler& compiler, bool tail) const {
+    for (const auto& init : inits) {
+        init->compile(compiler, false);
+    }
+    compiler.emit(OpCode::ENTER, frameSize, inits.size());
+    compiler.compileSequence(body, tail);
+    // 尾位置上的 let 随后就会 RETURN，不必再恢复环境
+    if (!tail) compiler.emit(OpCode::LEAVE);
+}
+
+void QuasiListNode::compile(Compiler& compiler, bool tail) const {
+    for (const auto& element : elements) {
+        element->compile(compiler, false);
+    }
+    compiler.emit(OpCode::LIST, elements.size());
+}
+
+void CallNode::compile(Compiler& compiler, bool tail) const {
+    proc->compile(compiler, false);
+    for (const auto& arg : args) {
+        arg->compile(compiler, false);
+    }
+    compiler.emit(tail ? OpCode::TAIL_CALL : OpCode::CALL, args.size());
+}
+
+void ConstantNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::CONSTANT));
+    writer.writeValue(value);
+}
+
+void GlobalVariableNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::GLOBAL_VARIABLE));
+    writer.writeSymbol(name);
+}
+
+void LocalVariableNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::LOCAL_VARIABLE));
+    writer.writeSymbol(name);
+    writer.writeUnsigned(depth);
+    writer.writeUnsigned(index);
+}
+
+void GlobalDefineNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::GLOBAL_DEFINE));
+    writer.writeSymbol(name);
+    writer.writeNode(value);
+}
+
+void LocalDefineNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::LOCAL_DEFINE));
+    writer.writeUnsigned(index);
+    writer.writeNode(value);
+}
+
+void LambdaNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::LAMBDA));
+    writer.writeUnsigned(params.size());
+    for (auto param : params) {
+        writer.writeSymbol(param);
+    }
+    writer.writeUnsigned(frameSize);
+    writer.writeNodes(body);
+}
+
+void IfNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::IF));
+    writer.writeNode(condition);
+    writer.writeNode(consequent);
+    writer.writeNode(alternative);
+}
+
+void AndNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::AND));
+    writer.writeNodes(operands);
+}
+
+void OrNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::OR));
+    writer.writeNodes(operands);
+}
+
+void CondNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::COND));
+    writer.writeUnsigned(clauses.size());
+    for (const auto& clause : clauses) {
+        writer.writeNode(clause.test);
+        writer.writeNodes(clause.body);
+    }
+}
+
+void BeginNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::BEGIN));
+    writer.writeNodes(body);
+}
+
+void LetNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::LET));
+    writer.writeNodes(inits);
+    writer.writeUnsigned(frameSize);
+    writer.writeNodes(body);
+}
+
+void QuasiListNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::QUASI_LIST));
+    writer.writeNodes(elements);
+}
+
+void CallNode::serialize(ImageWriter& writer) const {
+    writer.writeByte(static_cast<std::uint8_t>(NodeTag::CALL));
+    writer.writeNode(proc);
+    writer.writeNodes(args);
+}
@@ -0,0 +1,235 @@
+#ifndef NODE_H
+#define NODE_H
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "eval_env.h"
+#include "value.h"
+
+class Compiler;
+class ImageWriter;
+struct Code;
+
+// 尾位置上尚未执行的过程调用，由 LambdaValue::apply 的循环接着执行
+struct TailCall {
+    std::shared_ptr<LambdaValue> proc;
+    std::vector<ValuePtr> args;
+};
+
+// 语法分析后的可执行节点：每段代码只分析一次，之后反复执行节点树，
+// 或者由 compile 降低为字节码交给虚拟机执行
+class Node {
+public:
+    virtual ~Node() = default;
+    virtual ValuePtr eval(EvalEnv& env) const = 0;
+    // 在尾位置求值：若最终是对 lambda 的调用，则填入 call 并返回空指针
+    virtual ValuePtr evalTail(EvalEnv& env, TailCall& call) const {
+        return eval(env);
+    }
+    virtual void compile(Compiler& compiler, bool tail) const = 0;
+    // 写出节点的类型标记与各个字段，由 ImageReader 读回
+    virtual void serialize(ImageWriter& writer) const = 0;
+};
+
+using NodePtr = std::shared_ptr<const Node>;
+
+class ConstantNode : public Node {
+    ValuePtr value;
+
+public:
+    ConstantNode(ValuePtr value) : value(std::move(value)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class GlobalVariableNode : public Node {
+    Symbol name;
+    mutable GlobalCache cache;
+
+public:
+    GlobalVariableNode(Symbol name) : name(name) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+// 局部变量：向外 depth 层帧中的第 index 个槽位
+class LocalVariableNode : public Node {
+    Symbol name;
+    std::size_t depth;
+    std::size_t index;
+
+public:
+    LocalVariableNode(Symbol name, std::size_t depth, std::size_t index)
+        : name(name), depth(depth), index(index) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class GlobalDefineNode : public Node {
+    Symbol name;
+    NodePtr value;
+
+public:
+    GlobalDefineNode(Symbol name, NodePtr value)
+        : name(name), value(std::move(value)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+// 内部定义，写入当前帧的第 index 个槽位
+class LocalDefineNode : public Node {
+    std::size_t index;
+    NodePtr value;
+
+public:
+    LocalDefineNode(std::size_t index, NodePtr value)
+        : index(index), value(std::move(value)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class LambdaNode : public Node,
+                   public std::enable_shared_from_this<LambdaNode> {
+    std::vector<Symbol> params;
+    std::size_t frameSize;  // 参数与内部定义的槽位总数
+    std::vector<NodePtr> body;
+    mutable std::shared_ptr<const Code> compiled;  // 首次被虚拟机调用时生成
+
+public:
+    LambdaNode(const std::vector<Symbol>& params, std::size_t frameSize,
+               std::vector<NodePtr> body)
+        : params(params), frameSize(frameSize), body(std::move(body)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+    const std::vector<Symbol>& getParams() const {
+        return params;
+    }
+    const std::vector<NodePtr>& getBody() const {
+        return body;
+    }
+    const std::shared_ptr<const Code>& getCompiled() const;
+    // 检查实参个数，并在 definingEnv 下创建绑定好实参的新帧
+    std::shared_ptr<EvalEnv> bind(EvalEnv& definingEnv,
+                                  std::span<const ValuePtr> args) const;
+};
+
+class IfNode : public Node {
+    NodePtr condition;
+    NodePtr consequent;
+    NodePtr alternative;  // 可能为空
+
+public:
+    IfNode(NodePtr condition, NodePtr consequent, NodePtr alternative)
+        : condition(std::move(condition)),
+          consequent(std::move(consequent)),
+          alternative(std::move(alternative)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class AndNode : public Node {
+    std::vector<NodePtr> operands;
+
+public:
+    AndNode(std::vector<NodePtr> operands) : operands(std::move(operands)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class OrNode : public Node {
+    std::vector<NodePtr> operands;
+
+public:
+    OrNode(std::vector<NodePtr> operands) : operands(std::move(operands)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+struct CondClause {
+    NodePtr test;  // else 分支为空
+    std::vector<NodePtr> body;
+};
+
+class CondNode : public Node {
+    std::vector<CondClause> clauses;
+
+public:
+    CondNode(std::vector<CondClause> clauses) : clauses(std::move(clauses)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class BeginNode : public Node {
+    std::vector<NodePtr> body;
+
+public:
+    BeginNode(std::vector<NodePtr> body) : body(std::move(body)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class LetNode : public Node {
+    std::vector<NodePtr> inits;
+    std::size_t frameSize;
+    std::vector<NodePtr> body;
+
+public:
+    LetNode(std::vector<NodePtr> inits, std::size_t frameSize,
+            std::vector<NodePtr> body)
+        : inits(std::move(inits)),
+          frameSize(frameSize),
+          body(std::move(body)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+// quasiquote 模板中的列表，元素为已分析的节点（常量或 unquote 表达式）
+class QuasiListNode : public Node {
+    std::vector<NodePtr> elements;
+
+public:
+    QuasiListNode(std::vector<NodePtr> elements)
+        : elements(std::move(elements)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+class CallNode : public Node {
+    NodePtr proc;
+    std::vector<NodePtr> args;
+
+public:
+    CallNode(NodePtr proc, std::vector<NodePtr> args)
+        : proc(std::move(proc)), args(std::move(args)) {}
+    ValuePtr eval(EvalEnv& env) const override;
+    ValuePtr evalTail(EvalEnv& env, TailCall& call) const override;
+    void compile(Compiler& compiler, bool tail) const override;
+    void serialize(ImageWriter& writer) const override;
+};
+
+ValuePtr evalSequence(const std::vector<NodePtr>& body, EvalEnv& env);
+ValuePtr evalSequenceTail(const std::vector<NodePtr>& body, EvalEnv& env,
+                          TailCall& call);
+
+#endif
@@ -0,0 +1,224 @@
+#include "numeric.h"
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+#include "error.h"
+
+using Limits = std::numeric_limits<std::int64_t>;
+
+static bool bothIntegers(const Value& a, const Value& b) {
+    return a.getType() == ValueType::INTEGER &&
+           b.getType() == ValueType::INTEGER;
+}
+
+static std::int64_t intOf(const Value& v) {
+    return static_cast<const IntegerValue&>(v).getValue();
+}
+
+static BigInt bigOf(const Value& v) {
+    if (v.getType() == ValueType::INTEGER) return BigInt(intOf(v));
+    return static_cast<const BigIntValue&>(v).getValue();
+}
+
+static void checkNumbers(const Value& a, const Value& b) {
+    if (!a.isNumber() || !b.isNumber()) {
+        throw LispError("Arithmetic on a non-numeric value.");
+    }
+}
+
+ValuePtr makeInteger(const BigInt& value) {
+    if (value.fitsInt64()) return IntegerValue::of(value.toInt64());
+    return std::make_shared<BigIntValue>(value);
+}
+
+ValuePtr parseInteger(std::string_view text) {
+    // 18 位以内的十进制数一定在 int64 范围内
+    if (text.size() <= 18) {
+        if (text.front() == '+') text.remove_prefix(1);
+        std::int64_t value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return IntegerValue::of(value);
+    }
+    return makeInteger(BigInt::parse(std::string(text)));
+}
+
+ValuePtr numberAdd(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (bothIntegers(a, b)) {
+        auto x = intOf(a);
+        auto y = intOf(b);
+        if (y > 0 ? x <= Limits::max() - y : x >= Limits::min() - y) {
+            return IntegerValue::of(x + y);
+        }
+    } else if (!a.isExact() || !b.isExact()) {
+        return NumericValue::of(a.asNumber() + b.asNumber());
+    }
+    return makeInteger(bigOf(a) + bigOf(b));
+}
+
+ValuePtr numberSubtract(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (bothIntegers(a, b)) {
+        auto x = intOf(a);
+        auto y = intOf(b);
+        if (y > 0 ? x >= Limits::min() + y : x <= Limits::max() + y) {
+            return IntegerValue::of(x - y);
+        }
+    } else if (!a.isExact() || !b.isExact()) {
+        return NumericValue::of(a.asNumber() - b.asNumber());
+    }
+    return makeInteger(bigOf(a) - bigOf(b));
+}
+
+ValuePtr numberMultiply(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (bothIntegers(a, b)) {
+        auto x = intOf(a);
+        auto y = intOf(b);
+        // 两个因子都在 32 位以内时乘积不会溢出
+        constexpr std::int64_t SMALL = std::int64_t{1} << 31;
+        if (x > -SMALL && x < SMALL && y > -SMALL && y < SMALL) {
+            return IntegerValue::of(x * y);
+        }
+    } else if (!a.isExact() || !b.isExact()) {
+        return NumericValue::of(a.asNumber() * b.asNumber());
+    }
+    return makeInteger(bigOf(a) * bigOf(b));
+}
+
+ValuePtr numberDivide(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (numberIsZero(b)) {
+        throw LispError("Division by zero.");
+    }
+    if (a.isExact() && b.isExact()) {
+        // 能整除时结果仍是精确整数，否则退化为浮点数
+        if (bothIntegers(a, b) && intOf(b) != -1) {
+            if (intOf(a) % intOf(b) == 0) {
+                return IntegerValue::of(intOf(a) / intOf(b));
+            }
+        } else {
+            BigInt quotient;
+            BigInt remainder;
+            BigInt::divide(bigOf(a), bigOf(b), quotient, remainder);
+            if (remainder.isZero()) return makeInteger(quotient);
+        }
+    }
+    return NumericValue::of(a.asNumber() / b.asNumber());
+}
+
+ValuePtr numberQuotient(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (numberIsZero(b)) {
+        throw LispError("Division by zero in quotient.");
+    }
+    if (!a.isExact() || !b.isExact()) {
+        return NumericValue::of(std::trunc(a.asNumber() / b.asNumber()));
+    }
+    if (bothIntegers(a, b) && intOf(b) != -1) {
+        return IntegerValue::of(intOf(a) / intOf(b));
+    }
+    BigInt quotient;
+    BigInt remainder;
+    BigInt::divide(bigOf(a), bigOf(b), quotient, remainder);
+    return makeInteger(quotient);
+}
+
+ValuePtr numberRemainder(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (numberIsZero(b)) {
+        throw LispError("Division by zero in remainder.");
+    }
+    if (!a.isExact() || !b.isExact()) {
+        return NumericValue::of(std::fmod(a.asNumber(), b.asNumber()));
+    }
+    if (bothIntegers(a, b)) {
+        if (intOf(b) == -1) return IntegerValue::of(0);
+        return IntegerValue::of(intOf(a) % intOf(b));
+    }
+    BigInt quotient;
+    BigInt remainder;
+    BigInt::divide(bigOf(a), bigOf(b), quotient, remainder);
+    return makeInteger(remainder);
+}
+
+ValuePtr numberModulo(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (numberIsZero(b)) {
+        throw LispError("b-modulo division by zero.");
+    }
+    // 结果与除数同号
+    if (!a.isExact() || !b.isExact()) {
+        double y = b.asNumber();
+        double result = std::fmod(a.asNumber(), y);
+        if (result != 0 && (result < 0) != (y < 0)) result += y;
+        return NumericValue::of(result);
+    }
+    if (bothIntegers(a, b)) {
+        auto y = intOf(b);
+        if (y == -1) return IntegerValue::of(0);
+        auto result = intOf(a) % y;
+        if (result != 0 && (result < 0) != (y < 0)) result += y;
+        return IntegerValue::of(result);
+    }
+    BigInt quotient;
+    BigInt remainder;
+    auto divisor = bigOf(b);
+    BigInt::divide(bigOf(a), divisor, quotient, remainder);
+    if (!remainder.isZero() &&
+        remainder.isNegative() != divisor.isNegative()) {
+        remainder = remainder + divisor;
+    }
+    return makeInteger(remainder);
+}
+
+ValuePtr numberExpt(Value& base, Value& exponent) {
+    checkNumbers(base, exponent);
+    if (base.isExact() && exponent.getType() == ValueType::INTEGER &&
+        intOf(exponent) >= 0) {
+        // 平方求幂
+        BigInt result(1);
+        BigInt power = bigOf(base);
+        for (auto n = intOf(exponent); n > 0; n >>= 1) {
+            if (n & 1) result = result * power;
+            if (n > 1) power = power * power;
+        }
+        return makeInteger(result);
+    }
+    return NumericValue::of(std::pow(base.asNumber(), exponent.asNumber()));
+}
+
+ValuePtr numberNegate(Value& a) {
+    return numberSubtract(*IntegerValue::of(0), a);
+}
+
+int numberCompare(Value& a, Value& b) {
+    checkNumbers(a, b);
+    if (bothIntegers(a, b)) {
+        return intOf(a) < intOf(b) ? -1 : intOf(a) > intOf(b);
+    }
+    if (a.isExact() && b.isExact()) {
+        return BigInt::compare(bigOf(a), bigOf(b));
+    }
+    double x = a.asNumber();
+    double y = b.asNumber();
+    return x < y ? -1 : x > y;
+}
+
+bool numberIsZero(Value& a) {
+    switch (a.getType()) {
+        case ValueType::INTEGER: return intOf(a) == 0;
+        case ValueType::BIGINT: return false;  // 大整数总不在 int64 范围内
+        default: return a.asNumber() == 0;
+    }
+}
+
+bool numberIsOdd(Value& a) {
+    switch (a.getType()) {
+        case ValueType::INTEGER: return intOf(a) % 2 != 0;
+        case ValueType::BIGINT: return bigOf(a).isOdd();
+        default: return std::fmod(a.asNumber(), 2) != 0;
+    }
+}
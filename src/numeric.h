@@ -0,0 +1,32 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include <string>
+#include <string_view>
+
+#include "bigint.h"
+#include "value.h"
+
+// 数值运算：两个精确整数之间先走 int64 快速路径，溢出时提升为大整数；
+// 只要有一个操作数是浮点数，就按浮点数计算
+
+// 能放进 int64 的大整数化为 IntegerValue
+ValuePtr makeInteger(const BigInt& value);
+// 解析十进制整数字面量
+ValuePtr parseInteger(std::string_view text);
+
+ValuePtr numberAdd(Value& a, Value& b);
+ValuePtr numberSubtract(Value& a, Value& b);
+ValuePtr numberMultiply(Value& a, Value& b);
+ValuePtr numberDivide(Value& a, Value& b);
+ValuePtr numberQuotient(Value& a, Value& b);
+ValuePtr numberRemainder(Value& a, Value& b);
+ValuePtr numberModulo(Value& a, Value& b);
+ValuePtr numberExpt(Value& base, Value& exponent);
+ValuePtr numberNegate(Value& a);
+// 返回负数、零或正数
+int numberCompare(Value& a, Value& b);
+bool numberIsZero(Value& a);
+bool numberIsOdd(Value& a);
+
+#endif
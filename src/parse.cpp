@@ -4,64 +4,142 @@
 #include <memory>
 
 #include "./error.h"
+#include "./numeric.h"
+#include "./pool.h"
 #include "./value.h"
 
-ValuePtr Parser::parseTails() {
-    if (parseToken.front()->getType() == TokenType::RIGHT_PAREN) {
-        parseToken.pop_front();               // 弹出这个词法标记
-        return std::make_shared<NilValue>();  // 返回空表
+Parser::Parser(Tokenizer& tokenizer) : tokenizer(tokenizer) {}
+
+const Token& Parser::peek() {
+    if (!hasLookahead) {
+        lookahead = tokenizer.next();
+        hasLookahead = true;
+    }
+    if (lookahead.type == TokenType::END) {
+        throw SyntaxError("Unexpected end of input");
     }
-    auto car = this->parse();
-    if (parseToken.front()->getType() == TokenType::DOT) {
-        parseToken.pop_front();  // 弹出这个词法标记
-        auto cdr = this->parse();
-        if (parseToken.front()->getType() != TokenType::RIGHT_PAREN) {
-            throw SyntaxError("Expected ')'");
+    return lookahead;
+}
+
+Token Parser::take() {
+    peek();
+    hasLookahead = false;
+    return lookahead;
+}
+
+bool Parser::atEnd() {
+    if (!hasLookahead) {
+        lookahead = tokenizer.next();
+        hasLookahead = true;
+    }
+    return lookahead.type == TokenType::END;
+}
+
+namespace {
+
+// 还没有读完的列表、向量或引用前缀
+struct Frame {
+    TokenType type;  // LEFT_PAREN、VECTOR_BEGIN 或 QUOTE 等引用前缀
+    ListBuilder list;
+    std::vector<ValuePtr> elements;
+    bool empty = true;    // 列表中还没有元素
+    bool dotted = false;  // 已读到 '.'，下一个值作为列表的尾部
+};
+
+}  // namespace
+
+static ValuePtr parseAtom(const Token& token) {
+    if (token.type == TokenType::NUMERIC_LITERAL) {
+        if (token.integer) {
+            return parseInteger(token.text);
         }
-        parseToken.pop_front();  // 再弹出一个词法标记，它应当是 ')'
-        return std::make_shared<PairValue>(car, cdr);  // 返回对子 (car, cdr)
-    } else {
-        auto cdr = this->parseTails();
-        return std::make_shared<PairValue>(car, cdr);  // 返回对子 (car, cdr)
+        return NumericValue::of(token.number);
+    } else if (token.type == TokenType::BOOLEAN_LITERAL) {
+        return BooleanValue::of(token.boolean);
+    } else if (token.type == TokenType::STRING_LITERAL) {
+        return std::make_shared<StringValue>(std::string(token.text));
+    } else if (token.type == TokenType::IDENTIFIER) {
+        return SymbolValue::intern(token.text);
     }
+    throw SyntaxError("Unimplemented");
 }
 
-Parser::Parser(std::deque<TokenPtr> tokens) : parseToken(std::move(tokens)) {}
+// 'x、`x、,x 分别展开为 (quote x)、(quasiquote x)、(unquote x)
+static ValuePtr quoted(TokenType type, ValuePtr value) {
+    static const ValuePtr QUOTE = SymbolValue::intern("quote");
+    static const ValuePtr QUASIQUOTE = SymbolValue::intern("quasiquote");
+    static const ValuePtr UNQUOTE = SymbolValue::intern("unquote");
+    const auto& name = type == TokenType::QUOTE        ? QUOTE
+                       : type == TokenType::QUASIQUOTE ? QUASIQUOTE
+                                                       : UNQUOTE;
+    return makePooled<PairValue>(
+        name, makePooled<PairValue>(std::move(value), NilValue::instance()));
+}
 
+// 用显式的栈代替递归，嵌套深度和列表长度只受内存限制
 ValuePtr Parser::parse() {
-    auto token = std::move(parseToken.front());
-    parseToken.pop_front();
-    if (token->getType() == TokenType::NUMERIC_LITERAL) {
-        auto value = static_cast<NumericLiteralToken&>(*token).getValue();
-        return std::make_shared<NumericValue>(value);
-    } else if (token->getType() == TokenType::BOOLEAN_LITERAL) {
-        auto value = static_cast<BooleanLiteralToken&>(*token).getValue();
-        return std::make_shared<BooleanValue>(value);
-    } else if (token->getType() == TokenType::STRING_LITERAL) {
-        auto value = static_cast<StringLiteralToken&>(*token).getValue();
-        return std::make_shared<StringValue>(value);
-    } else if (token->getType() == TokenType::IDENTIFIER) {
-        auto value = static_cast<IdentifierToken&>(*token).getName();
-        return std::make_shared<SymbolValue>(value);  //
-    } else if (token->getType() == TokenType::LEFT_PAREN) {
-        return parseTails();
-    } else if (token->getType() == TokenType::QUOTE) {
-        return std::make_shared<PairValue>(
-            std::make_shared<SymbolValue>("quote"),
-            std::make_shared<PairValue>(
-                this->parse(),
-                std::make_shared<NilValue>()));  // 返回对子 (quote, (parse,
-                                                 // nil))
-    } else if (token->getType() == TokenType::QUASIQUOTE) {
-        return std::make_shared<PairValue>(
-            std::make_shared<SymbolValue>("quasiquote"),
-            std::make_shared<PairValue>(this->parse(),
-                                        std::make_shared<NilValue>()));
-    } else if (token->getType() == TokenType::UNQUOTE) {
-        return std::make_shared<PairValue>(
-            std::make_shared<SymbolValue>("unquote"),
-            std::make_shared<PairValue>(this->parse(),
-                                        std::make_shared<NilValue>()));
+    std::vector<Frame> stack;
+    while (true) {
+        auto token = take();
+        ValuePtr value;
+        switch (token.type) {
+            case TokenType::LEFT_PAREN:
+            case TokenType::VECTOR_BEGIN:
+            case TokenType::QUOTE:
+            case TokenType::QUASIQUOTE:
+            case TokenType::UNQUOTE:
+                stack.push_back(Frame{token.type});
+                continue;
+            case TokenType::DOT:
+                if (stack.empty() ||
+                    stack.back().type != TokenType::LEFT_PAREN ||
+                    stack.back().empty || stack.back().dotted) {
+                    throw SyntaxError("Unexpected '.'");
+                }
+                stack.back().dotted = true;
+                continue;
+            case TokenType::RIGHT_PAREN: {
+                if (stack.empty() ||
+                    (stack.back().type != TokenType::LEFT_PAREN &&
+                     stack.back().type != TokenType::VECTOR_BEGIN)) {
+                    throw SyntaxError("Unexpected ')'");
+                }
+                auto& frame = stack.back();
+                if (frame.dotted) {
+                    throw SyntaxError("Expected an expression after '.'");
+                }
+                if (frame.type == TokenType::VECTOR_BEGIN) {
+                    value = std::make_shared<VectorValue>(
+                        std::move(frame.elements));
+                } else {
+                    value = frame.list.build();
+                }
+                stack.pop_back();
+                break;
+            }
+            default: value = parseAtom(token);
+        }
+        // 把读完的值交给外层结构，引用前缀得到值后立即闭合
+        while (true) {
+            if (stack.empty()) return value;
+            auto& frame = stack.back();
+            if (frame.type == TokenType::LEFT_PAREN) {
+                if (!frame.dotted) {
+                    frame.list.push(std::move(value));
+                    frame.empty = false;
+                    break;
+                }
+                if (take().type != TokenType::RIGHT_PAREN) {
+                    throw SyntaxError("Expected ')'");
+                }
+                value = frame.list.build(std::move(value));
+            } else if (frame.type == TokenType::VECTOR_BEGIN) {
+                frame.elements.push_back(std::move(value));
+                break;
+            } else {
+                value = quoted(frame.type, std::move(value));
+            }
+            stack.pop_back();
+        }
     }
-    throw SyntaxError("Unimplemented");
-}
\ No newline at end of file
+}
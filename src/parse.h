@@ -1,19 +1,25 @@
 #ifndef PARSE_H  // 保护代码
 #define PARSE_H
 
-#include <deque>
 #include <iostream>
 
 #include "token.h"
+#include "tokenizer.h"
 #include "value.h"
 
+// 边读词法标记边构造值，只缓存一个向前看的标记
 class Parser {
-    std::deque<TokenPtr> parseToken;
+    Tokenizer& tokenizer;
+    Token lookahead;
+    bool hasLookahead = false;
+
+    const Token& peek();
+    Token take();
 
 public:
-    Parser(std::deque<TokenPtr> tokens);
+    explicit Parser(Tokenizer& tokenizer);
+    bool atEnd();  // 输入中是否已经没有更多表达式
     ValuePtr parse();
-    ValuePtr parseTails();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 固定大小对象的内存池：从 64KB 的块中顺序切出单元，释放的单元挂到空闲链表
+// 上复用，块本身不归还。解释器是单线程的，因此不加锁
+template <std::size_t Size, std::size_t Align>
+class FixedPool {
+    union Cell {
+        Cell* next;
+        alignas(Align) unsigned char storage[Size];
+    };
+    static constexpr std::size_t CHUNK_CELLS = 65536 / sizeof(Cell);
+
+    Cell* freeList = nullptr;
+    Cell* bump = nullptr;  // 当前块中下一个未使用的单元
+    Cell* end = nullptr;
+
+public:
+    // 析构函数是平凡的，静态对象析构之后释放也是安全的
+    static FixedPool& instance() {
+        static FixedPool pool;
+        return pool;
+    }
+
+    void* allocate() {
+        if (freeList) {
+            Cell* cell = freeList;
+            freeList = cell->next;
+            return cell;
+        }
+        if (bump == end) {
+            bump = static_cast<Cell*>(
+                ::operator new(CHUNK_CELLS * sizeof(Cell)));
+            end = bump + CHUNK_CELLS;
+        }
+        return bump++;
+    }
+
+    void deallocate(void* p) {
+        Cell* cell = static_cast<Cell*>(p);
+        cell->next = freeList;
+        freeList = cell;
+    }
+};
+
+// 供 std::allocate_shared 使用，使控制块和对象一起从对应大小的池中分配
+template <typename T>
+class PoolAllocator {
+    using Pool = FixedPool<sizeof(T), alignof(T)>;
+
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        if (n != 1) return std::allocator<T>().allocate(n);
+        return static_cast<T*>(Pool::instance().allocate());
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        if (n != 1) return std::allocator<T>().deallocate(p, n);
+        Pool::instance().deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const {
+        return true;
+    }
+};
+
+// 代替 std::make_shared，用于序对、数值、局部帧这类大量创建的小对象
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(),
+                                   std::forward<Args>(args)...);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "port.h"
+
+#include <iostream>
+
+#include "printer.h"
+
+OutputPortValue::OutputPortValue(std::ostream* sink)
+    : Value(ValueType::OUTPUT_PORT), sink(sink) {
+    if (sink) buffer.reserve(BUFFER_SIZE);
+}
+
+OutputPortValue::~OutputPortValue() {
+    flush();
+}
+
+void OutputPortValue::flushIfFull() {
+    if (sink && buffer.size() >= BUFFER_SIZE) {
+        sink->write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+void OutputPortValue::write(std::string_view text) {
+    buffer += text;
+    flushIfFull();
+}
+
+void OutputPortValue::write(char c) {
+    buffer += c;
+    flushIfFull();
+}
+
+void OutputPortValue::print(const Value& value) {
+    printValue(buffer, value);
+    flushIfFull();
+}
+
+void OutputPortValue::flush() {
+    if (!sink) return;
+    sink->write(buffer.data(), buffer.size());
+    sink->flush();
+    buffer.clear();
+}
+
+const std::shared_ptr<OutputPortValue>& standardOutputPort() {
+    static const auto port = std::make_shared<OutputPortValue>(&std::cout);
+    return port;
+}
@@ -0,0 +1,41 @@
+#ifndef PORT_H
+#define PORT_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "value.h"
+
+// 输出端口。写入的内容先追加到缓冲区：字符串端口一直保留，供
+// get-output-string 取出；文件端口攒满 BUFFER_SIZE 字节、显式 flush
+// 或端口析构时才整块交给底层流，不再每行刷新一次
+class OutputPortValue : public Value {
+    std::string buffer;
+    std::ostream* sink;  // 字符串端口为空
+
+    void flushIfFull();
+
+public:
+    static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+    explicit OutputPortValue(std::ostream* sink = nullptr);
+    ~OutputPortValue() override;
+
+    bool isStringPort() const {
+        return sink == nullptr;
+    }
+    const std::string& getString() const {
+        return buffer;
+    }
+    void write(std::string_view text);
+    void write(char c);
+    void print(const Value& value);  // 写入值的外部表示
+    void flush();
+};
+
+// 标准输出端口，程序退出时析构并写出剩余内容
+const std::shared_ptr<OutputPortValue>& standardOutputPort();
+
+#endif
@@ -0,0 +1,119 @@
+#include "printer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// 正在输出的列表或向量
+struct Frame {
+    const Value* rest;          // 列表中尚未输出的部分
+    const VectorValue* vector;  // 向量，输出列表时为空
+    std::size_t index;          // 已输出的元素个数
+};
+
+}  // namespace
+
+void printNumber(std::string& out, double value) {
+    char buffer[32];
+    std::to_chars_result result;
+    if (value == std::floor(value) && std::abs(value) < 1e15) {
+        result = std::to_chars(buffer, buffer + sizeof(buffer),
+                               static_cast<std::int64_t>(value));
+    } else {
+        result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    }
+    out.append(buffer, result.ptr);
+}
+
+static void printString(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+// 输出不含其他值的原子
+static void printAtom(std::string& out, const Value& value) {
+    switch (value.getType()) {
+        case ValueType::BOOLEAN:
+            out += value.isTrue() ? "#t" : "#f";
+            break;
+        case ValueType::INTEGER: {
+            char buffer[24];
+            auto result = std::to_chars(
+                buffer, buffer + sizeof(buffer),
+                static_cast<const IntegerValue&>(value).getValue());
+            out.append(buffer, result.ptr);
+            break;
+        }
+        case ValueType::BIGINT:
+            out += static_cast<const BigIntValue&>(value).getValue().toString();
+            break;
+        case ValueType::NUMERIC: {
+            auto number = static_cast<const NumericValue&>(value).getValue();
+            printNumber(out, number);
+            break;
+        }
+        case ValueType::STRING:
+            printString(out, static_cast<const StringValue&>(value).getValue());
+            break;
+        case ValueType::NIL: out += "()"; break;
+        case ValueType::SYMBOL:
+            out += static_cast<const SymbolValue&>(value).getName();
+            break;
+        case ValueType::BUILTIN:
+        case ValueType::LAMBDA: out += "#procedure"; break;
+        case ValueType::HASH_TABLE: out += "#hash-table"; break;
+        case ValueType::OUTPUT_PORT: out += "#output-port"; break;
+        default: break;
+    }
+}
+
+void printValue(std::string& out, const Value& root) {
+    std::vector<Frame> stack;
+    const Value* value = &root;
+    while (value) {
+        // 列表与向量只输出开括号，元素留给下面逐个取出
+        if (value->isPair()) {
+            out += '(';
+            stack.push_back({value, nullptr, 0});
+        } else if (value->getType() == ValueType::VECTOR) {
+            out += "#(";
+            stack.push_back(
+                {nullptr, static_cast<const VectorValue*>(value), 0});
+        } else {
+            printAtom(out, *value);
+        }
+        // 取出下一个要输出的值，已经输出完的列表与向量补上右括号
+        value = nullptr;
+        while (!value && !stack.empty()) {
+            auto& frame = stack.back();
+            if (frame.vector) {
+                const auto& values = frame.vector->getValues();
+                if (frame.index < values.size()) {
+                    if (frame.index > 0) out += ' ';
+                    value = values[frame.index++].get();
+                    continue;
+                }
+            } else if (frame.rest->isPair()) {
+                auto& pair = static_cast<const PairValue&>(*frame.rest);
+                if (frame.index++ > 0) out += ' ';
+                value = pair.getLeft().get();
+                frame.rest = pair.getRight().get();
+                continue;
+            } else if (!frame.rest->isNil()) {
+                out += " . ";
+                value = frame.rest;
+                frame.rest = NilValue::instance().get();
+                continue;
+            }
+            out += ')';
+            stack.pop_back();
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef PRINTER_H
+#define PRINTER_H
+
+#include <string>
+
+#include "value.h"
+
+// 把值的外部表示追加到 out 末尾。列表沿 cdr 链循环输出，嵌套的列表与
+// 向量记在显式的栈上，不为每个元素构造临时字符串
+void printValue(std::string& out, const Value& value);
+// 浮点数按最短的可往返表示输出，整数值按整数输出
+void printNumber(std::string& out, double value);
+
+#endif
@@ -19,6 +19,7 @@
 #endif
 #endif
 #include <deque>
+#include <filesystem>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -324,6 +325,9 @@ inline Value buildValueFromStr(const std::string& str) {
  * CONTROLLER *
  **************/
 
+// 期望求值抛出异常的用例用它代替期望输出
+inline const std::string ERROR_EXPECTED = "<error>";
+
 struct Cases {
     const char* name;
     std::vector<std::pair<std::string, std::optional<std::string>>> cases;
@@ -367,9 +371,15 @@ public:
             std::cout << "\033[1mTesting " << case_.name << "\033[0m\n";
             for (const auto& [input, output] : case_.cases) {
                 std::cout << input;
+                bool expectError = output && *output == ERROR_EXPECTED;
                 try {
                     auto result = env.eval(input);
                     std::cout << "\033[36m => " << result << "\033[0m";
+                    if (expectError) {
+                        std::cout << " \033[31mbad\033[0m \033[90m[expected "
+                                     "an error]\033[0m\n";
+                        continue;
+                    }
                     auto got = buildValueFromStr(result);
                     if (output) {
                         auto expected = buildValueFromStr(*output);
@@ -386,6 +396,14 @@ public:
                         successNum++;
                     }
                 } catch (std::exception& e) {
+                    // 只接受解释器报告的错误，bad_alloc 之类仍算失败
+                    if (expectError &&
+                        dynamic_cast<std::runtime_error*>(&e)) {
+                        std::cout << "\033[36m => error: " << e.what()
+                                  << "\033[0m \033[32mok\033[0m\n";
+                        successNum++;
+                        continue;
+                    }
                     std::cout << " \033[31mbad\033[0m";
                     if (output) {
                         auto expected = buildValueFromStr(*output);
@@ -613,6 +631,8 @@ public:
         #NAME, {
 #define RMLT_CASE(input, ...) \
     {input, PP_IF(PP_IS_EMPTY(__VA_ARGS__), std::nullopt, __VA_ARGS__)},
+#define RMLT_CASE_ERROR(input) \
+    {input, rjsj_mini_lisp_test::ERROR_EXPECTED},
 #define RMLT_END_CASES(...) \
     }                       \
     }                       \
@@ -736,6 +756,13 @@ RMLT_CASE("(begin 1 2)", "2")
 RMLT_CASE("(begin (print 1) (print 2) (print 3))")
 RMLT_CASE("(let ((x 5) (y 10)) (print x) (print y) (+ x y))", "15")
 RMLT_CASE("`(11 45 ,(* 2 7))", "(11 45 14)")
+// 经过 if、cond、let、and、or 与 begin 的尾调用不能让栈增长
+RMLT_CASE("(define (spin n)"
+          "  (if (= n 0)"
+          "      'done"
+          "      (cond ((odd? n) (let ((m (- n 1))) (and #t (spin m))))"
+          "            (else (begin (or #f (spin (- n 1))))))))")
+RMLT_CASE("(spin 1000000)", "done")
 RMLT_END_CASES()
 
 RMLT_BEGIN_CASES(Lv7Lib)
@@ -911,6 +938,25 @@ RMLT_CASE("(equal? \"abc\" 42)", "#f")
 RMLT_CASE("(equal? #f '())", "#f")
 RMLT_CASE("(equal? #f #f)", "#t")
 RMLT_CASE("(equal? #f #t)", "#f")
+// eqv? 区分精确数与非精确数；大整数按值比较，字符串按同一性比较
+RMLT_CASE("(eqv? 1 1.0)", "#f")
+RMLT_CASE("(eqv? 1.5 1.5)", "#t")
+RMLT_CASE("(equal? 1 1.0)", "#f")
+RMLT_CASE("(eqv? 18446744073709551616 (* 4294967296 4294967296))", "#t")
+RMLT_CASE("(eqv? 18446744073709551616 18446744073709551617)", "#f")
+RMLT_CASE("(equal? 18446744073709551616 (* 4294967296 4294967296))", "#t")
+RMLT_CASE("(eqv? \"abc\" \"abc\")", "#f")
+RMLT_CASE("(equal? \"\" \"\")", "#t")
+RMLT_CASE("(equal? \"abc\" \"abcd\")", "#f")
+// equal? 递归比较嵌套的列表与向量
+RMLT_CASE("(equal? (list 1 (vector 2 (list 3 \"x\")) 4) "
+          "(list 1 (vector 2 (list 3 \"x\")) 4))",
+          "#t")
+RMLT_CASE("(equal? (list 1 (vector 2 (list 3 \"x\")) 4) "
+          "(list 1 (vector 2 (list 3 \"y\")) 4))",
+          "#f")
+RMLT_CASE("(equal? (vector 1 (list 2)) (vector 1 (list 2) 3))", "#f")
+RMLT_CASE("(equal? (vector (vector)) (vector (list)))", "#f")
 RMLT_CASE("(not #f)", "#t")
 RMLT_CASE("(not #t)", "#f")
 RMLT_CASE("(not 0)", "#f")
@@ -939,6 +985,16 @@ RMLT_CASE("(even? -1)", "#f")
 RMLT_CASE("(odd? -1)", "#t")
 RMLT_CASE("(zero? 0)", "#t")
 RMLT_CASE("(zero? 1)", "#f")
+// 调用处缓存了全局绑定之后重新定义，必须看到新的值
+RMLT_CASE("(define (g) 1)")
+RMLT_CASE("(define (call-g) (g))")
+RMLT_CASE("(call-g)", "1")
+RMLT_CASE("(define (g) 2)")
+RMLT_CASE("(call-g)", "2")
+RMLT_CASE("(define (first-of x) (car x))")
+RMLT_CASE("(first-of '(1 2))", "1")
+RMLT_CASE("(define (car x) 'mine)")
+RMLT_CASE("(first-of '(1 2))", "mine")
 RMLT_END_CASES()
 
 RMLT_BEGIN_CASES(Sicp)
@@ -1185,8 +1241,345 @@ RMLT_CASE("(define (len s) (if (eq? s '()) 0 (+ 1 (len (cdr s)))))")
 RMLT_CASE("(len '(1 2 3 4))", "4")
 RMLT_END_CASES()
 
+RMLT_BEGIN_CASES(Bignum)
+// 数值比较按浮点进行，大整数的精确结果用 = 与字面量比较
+RMLT_CASE("(define max 9223372036854775807)")
+RMLT_CASE("(define min -9223372036854775808)")
+RMLT_CASE("(= (+ max 1) 9223372036854775808)", "#t")
+RMLT_CASE("(= (+ 1 max) 9223372036854775808)", "#t")
+RMLT_CASE("(= (- min 1) -9223372036854775809)", "#t")
+RMLT_CASE("(= (- 0 min) 9223372036854775808)", "#t")
+RMLT_CASE("(= (* min -1) 9223372036854775808)", "#t")
+RMLT_CASE("(= (abs min) 9223372036854775808)", "#t")
+RMLT_CASE("(= (* max 2) 18446744073709551614)", "#t")
+RMLT_CASE("(= (* 4294967296 4294967296) 18446744073709551616)", "#t")
+RMLT_CASE("(= (expt 2 100) 1267650600228229401496703205376)", "#t")
+RMLT_CASE("(< max (+ max 1))", "#t")
+RMLT_CASE("(integer? (+ max 1))", "#t")
+RMLT_CASE("(= (quotient 18446744073709551616 -3) -6148914691236517205)",
+          "#t")
+RMLT_CASE("(modulo 18446744073709551616 -3)", "-2")
+RMLT_CASE("(modulo -18446744073709551616 3)", "2")
+RMLT_CASE("(remainder -18446744073709551616 3)", "-1")
+RMLT_CASE("(quotient 18446744073709551616 18446744073709551616)", "1")
+RMLT_CASE("(modulo (expt 10 30) 7)", "1")
+// 结果回到 int64 范围内时换回定长整数
+RMLT_CASE("(eqv? (- (+ max 1) 1) max)", "#t")
+RMLT_CASE("(eqv? (+ (- min 1) 1) min)", "#t")
+RMLT_CASE("(eqv? (quotient (* max 4) 4) max)", "#t")
+RMLT_CASE("(- (+ max 1) (+ max 1))", "0")
+RMLT_CASE("(+ (- (+ max 1) max) 41)", "42")
+RMLT_END_CASES()
+
+RMLT_BEGIN_CASES(HashTable)
+RMLT_CASE("(define h (make-hash-table))")
+RMLT_CASE("(define (fill! i n) (if (< i n) (begin (hash-set! h i (* i i)) "
+          "(fill! (+ i 1) n))))")
+RMLT_CASE("(define (drop-evens! i n) (if (< i n) (begin (hash-remove! h i) "
+          "(drop-evens! (+ i 2) n))))")
+RMLT_CASE("(define (odds-only? i n) (cond ((>= i n) #t) "
+          "((hash-has-key? h i) #f) "
+          "((= (hash-ref h (+ i 1)) (* (+ i 1) (+ i 1))) "
+          "(odds-only? (+ i 2) n)) (else #f)))")
+// 插入过程中多次扩容，再删去一半留下墓碑
+RMLT_CASE("(fill! 0 1000)")
+RMLT_CASE("(hash-count h)", "1000")
+RMLT_CASE("(drop-evens! 0 1000)")
+RMLT_CASE("(hash-count h)", "500")
+RMLT_CASE("(odds-only? 0 1000)", "#t")
+RMLT_CASE("(hash-remove! h 0)")
+RMLT_CASE("(hash-count h)", "500")
+RMLT_CASE("(fill! 0 1000)")
+RMLT_CASE("(hash-count h)", "1000")
+RMLT_CASE("(hash-ref h 998)", "996004")
+// 反复插入删除同一个键，墓碑被重用，计数不变
+RMLT_CASE("(define (churn! i) (if (> i 0) (begin (hash-set! h 'k i) "
+          "(hash-remove! h 'k) (churn! (- i 1)))))")
+RMLT_CASE("(churn! 5000)")
+RMLT_CASE("(hash-count h)", "1000")
+RMLT_CASE("(hash-has-key? h 'k)", "#f")
+RMLT_CASE("(hash-ref h 'k 'none)", "none")
+RMLT_CASE("(hash-set! h 'k 1)")
+RMLT_CASE("(hash-set! h 'k 2)")
+RMLT_CASE("(hash-count h)", "1001")
+RMLT_CASE("(hash-ref h 'k)", "2")
+RMLT_CASE("(hash-clear! h)")
+RMLT_CASE("(hash-count h)", "0")
+RMLT_CASE("(hash-keys h)", "()")
+// equal? 表按结构比较键
+RMLT_CASE("(define e (make-hash-table))")
+RMLT_CASE("(hash-set! e \"abc\" 1)")
+RMLT_CASE("(hash-set! e (list 1 2 (list 3)) 2)")
+RMLT_CASE("(hash-set! e 18446744073709551616 3)")
+RMLT_CASE("(hash-ref e \"abc\")", "1")
+RMLT_CASE("(hash-ref e '(1 2 (3)))", "2")
+RMLT_CASE("(hash-ref e '(1 2 3) 'none)", "none")
+RMLT_CASE("(hash-ref e (* 4294967296 4294967296))", "3")
+RMLT_CASE("(hash-set! e (list 1 2 (list 3)) 4)")
+RMLT_CASE("(hash-count e)", "3")
+RMLT_CASE("(hash-remove! e \"abc\")")
+RMLT_CASE("(hash-count e)", "2")
+RMLT_CASE("(hash-has-key? e \"abc\")", "#f")
+RMLT_CASE("(hash-ref e '(1 2 (3)))", "4")
+// 只在末尾不同的长向量：散列只看前面的元素，仍要靠 equal? 区分
+RMLT_CASE("(define a (make-vector 1000 0))")
+RMLT_CASE("(define b (make-vector 1000 0))")
+RMLT_CASE("(vector-set! b 999 1)")
+RMLT_CASE("(hash-set! e a 'a)")
+RMLT_CASE("(hash-set! e b 'b)")
+RMLT_CASE("(hash-ref e (make-vector 1000 0))", "a")
+RMLT_CASE("(hash-ref e b)", "b")
+RMLT_CASE("(hash-count e)", "4")
+// 前 64 个结点相同的长列表与深层嵌套的列表：散列相同，键仍各自独立
+RMLT_CASE("(define (ones n end) (if (= n 0) (list end) "
+          "(cons 1 (ones (- n 1) end))))")
+RMLT_CASE("(define (nest n x) (if (= n 0) x (list (nest (- n 1) x))))")
+RMLT_CASE("(hash-set! e (ones 100 'a) 'long-a)")
+RMLT_CASE("(hash-set! e (ones 100 'b) 'long-b)")
+RMLT_CASE("(hash-set! e (nest 100 'a) 'deep-a)")
+RMLT_CASE("(hash-set! e (nest 100 'b) 'deep-b)")
+RMLT_CASE("(hash-ref e (ones 100 'a))", "long-a")
+RMLT_CASE("(hash-ref e (ones 100 'b))", "long-b")
+RMLT_CASE("(hash-ref e (ones 100 'c) 'none)", "none")
+RMLT_CASE("(hash-ref e (nest 100 'a))", "deep-a")
+RMLT_CASE("(hash-ref e (nest 100 'b))", "deep-b")
+RMLT_CASE("(hash-ref e (nest 99 'a) 'none)", "none")
+RMLT_CASE("(hash-count e)", "8")
+// eq? 表按同一性比较
+RMLT_CASE("(define q (make-hash-table eq?))")
+RMLT_CASE("(define key (list 1 2))")
+RMLT_CASE("(hash-set! q key 1)")
+RMLT_CASE("(hash-ref q key)", "1")
+RMLT_CASE("(hash-ref q (list 1 2) 'none)", "none")
+RMLT_END_CASES()
+
+RMLT_BEGIN_CASES(Vector)
+// 向量的求值结果以 # 开头，测试框架只认作过程；借字符串端口比较打印结果
+RMLT_CASE("(define (repr x) (let ((port (open-output-string))) "
+          "(display x port) (get-output-string port)))")
+RMLT_CASE("(repr (vector))", "\"'#()\"")
+RMLT_CASE("(repr (vector 1 \"s\" 'a))", "\"'#(1 \\\"s\\\" a)\"")
+RMLT_CASE("(repr '#(1 #(2) (3 . 4)))", "\"'#(1 #(2) (3 . 4))\"")
+RMLT_CASE("(repr (list 1 (vector 2)))", "\"'(1 #(2))\"")
+RMLT_CASE("(repr (make-vector 3 'a))", "\"'#(a a a)\"")
+RMLT_CASE("(repr (make-vector 2))", "\"'#(0 0)\"")
+RMLT_CASE("(vector-length (make-vector 0))", "0")
+RMLT_CASE("(vector? (make-vector 2 0))", "#t")
+RMLT_CASE("(vector? '(1 2))", "#f")
+RMLT_CASE("(define v (vector 1 2 3))")
+RMLT_CASE("(vector-ref v 0)", "1")
+RMLT_CASE("(vector-ref v 2)", "3")
+RMLT_CASE("(vector-set! v 1 'x)")
+RMLT_CASE("(vector-ref v 1)", "x")
+RMLT_CASE("(vector-fill! v 7)")
+RMLT_CASE("(repr v)", "\"'#(7 7 7)\"")
+RMLT_CASE("(repr (vector-map (lambda (x) (* x x)) #(1 2 3)))",
+          "\"'#(1 4 9)\"")
+// 下标越界与类型错误
+RMLT_CASE_ERROR("(vector-ref v 3)")
+RMLT_CASE_ERROR("(vector-ref v -1)")
+RMLT_CASE_ERROR("(vector-ref v 1.5)")
+RMLT_CASE_ERROR("(vector-ref (vector) 0)")
+RMLT_CASE_ERROR("(vector-set! v 3 0)")
+RMLT_CASE_ERROR("(vector-set! v -1 0)")
+RMLT_CASE_ERROR("(vector-ref '(1 2) 0)")
+RMLT_CASE_ERROR("(make-vector -1)")
+RMLT_CASE("(repr v)", "\"'#(7 7 7)\"")
+// 列表与向量互转
+RMLT_CASE("(vector->list (list->vector '(1 2 3)))", "(1 2 3)")
+RMLT_CASE("(vector->list (vector))", "()")
+RMLT_CASE("(repr (list->vector '()))", "\"'#()\"")
+RMLT_CASE("(repr (list->vector (vector->list #(1 (2) \"x\"))))",
+          "\"'#(1 (2) \\\"x\\\")\"")
+RMLT_CASE("(equal? (list->vector (vector->list #(1 (2)))) #(1 (2)))", "#t")
+RMLT_CASE("(repr (vector->list (list->vector (list v v))))",
+          "\"'(#(7 7 7) #(7 7 7))\"")
+RMLT_CASE_ERROR("(vector-length 1)")
+RMLT_CASE_ERROR("(list->vector '(1 . 2))")
+RMLT_CASE_ERROR("(vector->list '(1 2))")
+// 释放序对与向量交错的深层嵌套时不会递归耗尽栈
+RMLT_CASE("(define (nest n acc) (if (= n 0) acc "
+          "(nest (- n 1) (vector (list n acc)))))")
+RMLT_CASE("(define deep (nest 200000 '()))")
+RMLT_CASE("(vector-length deep)", "1")
+RMLT_CASE("(define deep 0)")
+RMLT_CASE("deep", "0")
+RMLT_END_CASES()
+
+// 路径会写进 Lisp 字符串，其中反斜杠是转义符，统一换成正斜杠
+static std::string rmltLispPath(std::string path) {
+    for (auto& c : path) {
+        if (c == '\\') c = '/';
+    }
+    return path;
+}
+
+// 测试用的脚本放在仓库的 tests 目录下，按本文件所在的位置找到它们
+static std::string rmltFixture(const std::string& name) {
+    auto path = rmltLispPath(__FILE__);
+    // 去掉末尾的 src/rjsj_test.hpp 两级
+    auto slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        slash = path.rfind('/', slash - 1);
+    }
+    auto root = slash == std::string::npos ? std::string("./")
+                                           : path.substr(0, slash + 1);
+    return root + "tests/" + name;
+}
+
+// 测试中写出的临时文件
+static std::string rmltTempFile(const std::string& name) {
+    return rmltLispPath(
+        (std::filesystem::temp_directory_path() / name).string());
+}
+
+RMLT_BEGIN_CASES(Load)
+RMLT_CASE("(load \"" + rmltFixture("load.scm") + "\")", "49")
+RMLT_CASE("loaded-value", "42")
+RMLT_CASE("(loaded-square 3)", "9")
+// 在过程中载入，定义仍写入全局环境
+RMLT_CASE("(define (reload) (load \"" + rmltFixture("load.scm") + "\"))")
+RMLT_CASE("(define loaded-value 0)")
+RMLT_CASE("(reload)", "49")
+RMLT_CASE("loaded-value", "42")
+// 出错的脚本停在出错处，此前的定义保留
+RMLT_CASE_ERROR("(load \"" + rmltFixture("load-error.scm") + "\")")
+RMLT_CASE("before-error", "1")
+RMLT_CASE_ERROR("after-error")
+// 文件不存在
+RMLT_CASE_ERROR("(load \"" + rmltFixture("missing.scm") + "\")")
+RMLT_CASE_ERROR("(load \"\")")
+RMLT_CASE_ERROR("(load 'load.scm)")
+RMLT_CASE("(+ loaded-value 1)", "43")
+RMLT_END_CASES()
+
+RMLT_BEGIN_CASES(Fasl)
+RMLT_CASE("(define fasl \"" + rmltTempFile("mini_lisp_test.fasl") + "\")")
+RMLT_CASE("(define (round-trip x) (write-fasl x fasl) (read-fasl fasl))")
+RMLT_CASE("(round-trip 42)", "42")
+RMLT_CASE("(round-trip '(1 -2.5 \"s\" sym #t ()))", "(1 -2.5 \"s\" sym #t ())")
+RMLT_CASE("(= (round-trip 18446744073709551616) 18446744073709551616)", "#t")
+// 共享的子结构读回后仍是同一个对象
+RMLT_CASE("(define shared (list 1 2))")
+RMLT_CASE("(define data (list shared shared (vector shared \"s\") 'x))")
+RMLT_CASE("(define back (round-trip data))")
+RMLT_CASE("(equal? back data)", "#t")
+RMLT_CASE("(eq? (car back) shared)", "#f")
+RMLT_CASE("(eq? (car back) (car (cdr back)))", "#t")
+RMLT_CASE("(eq? (car back) (vector-ref (car (cdr (cdr back))) 0))", "#t")
+RMLT_CASE("(eq? (car (cdr (cdr (cdr back)))) 'x)", "#t")
+// 散列表，包括引用自身的散列表
+RMLT_CASE("(define h (make-hash-table))")
+RMLT_CASE("(hash-set! h 'self h)")
+RMLT_CASE("(hash-set! h \"key\" '(1 2))")
+RMLT_CASE("(hash-set! h '(a b) 3)")
+RMLT_CASE("(define h2 (round-trip h))")
+RMLT_CASE("(hash-count h2)", "3")
+RMLT_CASE("(eq? (hash-ref h2 'self) h2)", "#t")
+RMLT_CASE("(hash-ref h2 \"key\")", "(1 2)")
+RMLT_CASE("(hash-ref h2 '(a b))", "3")
+RMLT_CASE("(define q (make-hash-table eq?))")
+RMLT_CASE("(hash-set! q 'a 1)")
+RMLT_CASE("(hash-ref (round-trip q) 'a)", "1")
+// 闭包连同它捕获的环境帧；共享同一帧的闭包读回后仍共享
+RMLT_CASE("(define (make-sum start) (define (sum n) "
+          "(if (= n 0) start (+ n (sum (- n 1))))) sum)")
+RMLT_CASE("(define procs (round-trip (list (make-sum 100) + car)))")
+RMLT_CASE("((car procs) 4)", "110")
+RMLT_CASE("((car (cdr procs)) 1 2)", "3")
+RMLT_CASE("((car (cdr (cdr procs))) '(7 8))", "7")
+RMLT_CASE("(define (both x) (list (lambda () x) (lambda (y) (+ x y))))")
+RMLT_CASE("(define pair (round-trip (both 7)))")
+RMLT_CASE("((car pair))", "7")
+RMLT_CASE("((car (cdr pair)) 1)", "8")
+// 深层嵌套的数据不会递归耗尽栈
+RMLT_CASE("(define (nest n acc) (if (= n 0) acc "
+          "(nest (- n 1) (list (vector acc)))))")
+RMLT_CASE("(define (depth x n) (if (pair? x) "
+          "(depth (vector-ref (car x) 0) (+ n 1)) n))")
+RMLT_CASE("(depth (round-trip (nest 100000 '())) 0)", "100000")
+// 无法写出的值，以及截断、损坏或格式不符的文件
+RMLT_CASE_ERROR("(write-fasl (open-output-string) fasl)")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("truncated.fasl") + "\")")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("corrupt.fasl") + "\")")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("bad-frame-size.fasl") + "\")")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("bad-slot.fasl") + "\")")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("bad-depth.fasl") + "\")")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("load.scm") + "\")")
+RMLT_CASE_ERROR("(read-fasl \"" + rmltFixture("missing.fasl") + "\")")
+RMLT_END_CASES()
+
+RMLT_BEGIN_CASES(Port)
+RMLT_CASE("(define p (open-output-string))")
+RMLT_CASE("(get-output-string p)", "\"\"")
+RMLT_CASE("(display \"abc\" p)")
+RMLT_CASE("(get-output-string p)", "\"abc\"")
+RMLT_CASE("(display 42 p)")
+RMLT_CASE("(newline p)")
+RMLT_CASE("(displayln '(1 \"x\") p)")
+RMLT_CASE("(get-output-string p)", "\"abc'42\\n'(1 \\\"x\\\")\\n\"")
+// 取出内容不会清空端口，刷新字符串端口也不会
+RMLT_CASE("(flush-output p)")
+RMLT_CASE("(get-output-string p)", "\"abc'42\\n'(1 \\\"x\\\")\\n\"")
+RMLT_CASE("(define q (open-output-string))")
+RMLT_CASE("(display \"q\" q)")
+RMLT_CASE("(get-output-string q)", "\"q\"")
+RMLT_CASE("(get-output-string p)", "\"abc'42\\n'(1 \\\"x\\\")\\n\"")
+// 不给端口时写到标准输出
+RMLT_CASE("(display \"to stdout\")")
+RMLT_CASE("(flush-output)")
+RMLT_CASE("(newline)")
+// 十万层嵌套的字面量：读入与打印都不能递归耗尽 C++ 栈
+RMLT_CASE("(define deep '" + std::string(100000, '(') +
+          std::string(100000, ')') + ")")
+RMLT_CASE("(define (depth x n) (if (null? x) n (depth (car x) (+ n 1))))")
+RMLT_CASE("(depth deep 0)", "99999")
+RMLT_CASE("(define (repr x) (let ((port (open-output-string))) "
+          "(display x port) (get-output-string port)))")
+RMLT_CASE("(equal? (repr deep) \"'" + std::string(100000, '(') +
+              std::string(100000, ')') + "\")",
+          "#t")
+// 非精确数按能读回原值的最短形式输出，指数形式与 printf 的 %g 相同
+RMLT_CASE("(repr (/ 1 3))", "\"'0.3333333333333333\"")
+RMLT_CASE("(repr (+ 0.1 0.2))", "\"'0.30000000000000004\"")
+RMLT_CASE("(repr 1e21)", "\"'1e+21\"")
+RMLT_CASE("(repr 1e-7)", "\"'1e-07\"")
+RMLT_CASE("(repr -2.5)", "\"'-2.5\"")
+RMLT_CASE("(repr 2.0)", "\"'2\"")
+RMLT_CASE_ERROR("(display 1 2)")
+RMLT_CASE_ERROR("(newline \"p\")")
+RMLT_CASE_ERROR("(flush-output 'p)")
+RMLT_CASE_ERROR("(get-output-string 'p)")
+RMLT_CASE_ERROR("(open-output-string 1)")
+RMLT_END_CASES()
+
+RMLT_BEGIN_CASES(Gc)
+// 只由向量、散列表彼此引用的环不经过任何环境，也要被回收
+RMLT_CASE("(define (self-table) "
+          "(let ((h (make-hash-table))) (hash-set! h 'self h)))")
+RMLT_CASE("(define (self-vector) "
+          "(let ((v (make-vector 2 0))) (vector-set! v 0 v)))")
+RMLT_CASE("(define (table-vector) (let ((h (make-hash-table)) (v (vector 0))) "
+          "(hash-set! h 'v (list v)) (vector-set! v 0 h)))")
+RMLT_CASE("(collect-garbage)")
+RMLT_CASE("(self-table)")
+RMLT_CASE("(self-table)")
+RMLT_CASE("(self-vector)")
+RMLT_CASE("(collect-garbage)", "3")
+// 散列表、序对与向量构成的环
+RMLT_CASE("(table-vector)")
+RMLT_CASE("(collect-garbage)", "3")
+RMLT_CASE("(collect-garbage)", "0")
+// 仍被全局变量引用的环保持原样
+RMLT_CASE("(define kept (make-vector 1 0))")
+RMLT_CASE("(vector-set! kept 0 kept)")
+RMLT_CASE("(collect-garbage)", "0")
+RMLT_CASE("(eq? (vector-ref kept 0) kept)", "#t")
+RMLT_END_CASES()
+
 #undef RMLT_BEGIN_CASES
 #undef RMLT_CASE
+#undef RMLT_CASE_ERROR
 #undef RMLT_END_CASES
 
 #endif
@@ -5,24 +5,6 @@
 
 using namespace std::literals;
 
-TokenPtr Token::fromChar(char c) {
-    TokenType type;
-    switch (c) {
-        case '(': type = TokenType::LEFT_PAREN; break;
-        case ')': type = TokenType::RIGHT_PAREN; break;
-        case '\'': type = TokenType::QUOTE; break;
-        case '`': type = TokenType::QUASIQUOTE; break;
-        case ',': type = TokenType::UNQUOTE; break;
-        // DOT not listed here, because it can be part of identifier/literal.
-        default: return nullptr;
-    }
-    return TokenPtr(new Token(type));
-}
-
-TokenPtr Token::dot() {
-    return TokenPtr(new Token(TokenType::DOT));
-}
-
 std::string Token::toString() const {
     switch (type) {
         case TokenType::LEFT_PAREN: return "(LEFT_PAREN)"; break;
@@ -31,38 +13,23 @@ std::string Token::toString() const {
         case TokenType::QUASIQUOTE: return "(QUASIQUOTE)"; break;
         case TokenType::UNQUOTE: return "(UNQUOTE)"; break;
         case TokenType::DOT: return "(DOT)"; break;
+        case TokenType::VECTOR_BEGIN: return "(VECTOR_BEGIN)"; break;
+        case TokenType::END: return "(END)"; break;
+        case TokenType::BOOLEAN_LITERAL:
+            return "(BOOLEAN_LITERAL "s + (boolean ? "true" : "false") + ")";
+        case TokenType::NUMERIC_LITERAL:
+            return "(NUMERIC_LITERAL " + std::string(text) + ")";
+        case TokenType::STRING_LITERAL: {
+            std::ostringstream ss;
+            ss << "(STRING_LITERAL " << std::quoted(std::string(text)) << ")";
+            return ss.str();
+        }
+        case TokenType::IDENTIFIER:
+            return "(IDENTIFIER " + std::string(text) + ")";
         default: return "(UNKNOWN)";
     }
 }
 
-std::unique_ptr<BooleanLiteralToken> BooleanLiteralToken::fromChar(char c) {
-    if (c == 't') {
-        return std::make_unique<BooleanLiteralToken>(true);
-    } else if (c == 'f') {
-        return std::make_unique<BooleanLiteralToken>(false);
-    } else {
-        return nullptr;
-    }
-}
-
-std::string BooleanLiteralToken::toString() const {
-    return "(BOOLEAN_LITERAL "s + (value ? "true" : "false") + ")";
-}
-
-std::string NumericLiteralToken::toString() const {
-    return "(NUMERIC_LITERAL " + std::to_string(value) + ")";
-}
-
-std::string StringLiteralToken::toString() const {
-    std::ostringstream ss;
-    ss << "(STRING_LITERAL " << std::quoted(value) << ")";
-    return ss.str();
-}
-
-std::string IdentifierToken::toString() const {
-    return "(IDENTIFIER " + name + ")";
-}
-
 std::ostream& operator<<(std::ostream& os, const Token& token) {
     return os << token.toString();
 }
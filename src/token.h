@@ -1,10 +1,9 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <memory>
-#include <optional>
 #include <ostream>
 #include <string>
+#include <string_view>
 
 enum class TokenType {
     LEFT_PAREN,//左括号(
@@ -17,82 +16,20 @@ enum class TokenType {
     NUMERIC_LITERAL,//数字
     STRING_LITERAL,//字符串
     IDENTIFIER,//标识符(变量名)
+    VECTOR_BEGIN,//向量字面量的开头 #(
+    END,//输入结束
 };//使用enum来定义做type的常数
 
-class Token;
-using TokenPtr = std::unique_ptr<Token>;
+// 词法标记按值传递，不单独分配内存。text 指向分词器内部的缓冲区，
+// 只在读取下一个标记之前有效
+struct Token {
+    TokenType type = TokenType::END;
+    std::string_view text;  // 标识符名、字符串内容或数字字面量原文
+    double number = 0;      // 非整数数字字面量的值
+    bool integer = false;   // 数字字面量是否为精确整数
+    bool boolean = false;   // 布尔字面量的值
 
-class Token {
-private:
-    TokenType type;
-
-protected:
-    Token(TokenType type) : type{type} {}
-
-public:
-    virtual ~Token() = default;
-
-    static TokenPtr fromChar(char c);
-    static TokenPtr dot();
-
-    TokenType getType() const {
-        return type;
-    }
-    virtual std::string toString() const;
-};
-
-class BooleanLiteralToken : public Token {
-private:
-    bool value;
-
-public:
-    BooleanLiteralToken(bool value) : Token(TokenType::BOOLEAN_LITERAL), value{value} {}
-
-    static std::unique_ptr<BooleanLiteralToken> fromChar(char c);
-
-    bool getValue() const {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class NumericLiteralToken : public Token {
-private:
-    double value;
-
-public:
-    NumericLiteralToken(double value) : Token(TokenType::NUMERIC_LITERAL), value{value} {}
-
-    double getValue() const {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class StringLiteralToken : public Token {
-private:
-    std::string value;
-
-public:
-    StringLiteralToken(const std::string& value) : Token(TokenType::STRING_LITERAL), value{value} {}
-
-    const std::string& getValue() const {
-        return value;
-    }
-    std::string toString() const override;
-};
-
-class IdentifierToken : public Token {
-private:
-    std::string name;
-
-public:
-    IdentifierToken(const std::string& name) : Token(TokenType::IDENTIFIER), name{name} {}
-
-    const std::string& getName() const {
-        return name;
-    }
-    std::string toString() const override;
+    std::string toString() const;
 };
 
 std::ostream& operator<<(std::ostream& os, const Token& token);
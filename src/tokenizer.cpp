@@ -1,91 +1,140 @@
 #include "./tokenizer.h"
 
 #include <cctype>
-#include <set>
-#include <stdexcept>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
 
 #include "./error.h"
 
-const std::set<char> TOKEN_END{'(', ')', '\'', '`', ',', '"'};//关联容器
+static bool isDelimiter(int c) {
+    switch (c) {
+        case '(': case ')': case '\'': case '`': case ',': case '"':
+            return true;
+        default: return std::isspace(c);
+    }
+}
+
+static Token makeToken(TokenType type) {
+    return Token{type};
+}
+
+int Tokenizer::peek() {
+    return input->sgetc();
+}
 
-TokenPtr Tokenizer::nextToken(int& pos) {
-    while (pos < input.size()) {
-        auto c = input[pos];
+int Tokenizer::get() {
+    return input->sbumpc();
+}
+
+Token Tokenizer::next() {
+    int c;
+    while ((c = peek()) != EOF) {
         if (c == ';') {
-            while (pos < input.size() && input[pos] != '\n') {
-                pos++;
+            while ((c = peek()) != EOF && c != '\n') {
+                get();
             }
         } else if (std::isspace(c)) {
-            pos++;
-        } else if (auto token = Token::fromChar(c)) {//返回的指针非空时为真
-            pos++;
-            return token;
+            get();
+        } else if (c == '(') {
+            get();
+            return makeToken(TokenType::LEFT_PAREN);
+        } else if (c == ')') {
+            get();
+            return makeToken(TokenType::RIGHT_PAREN);
+        } else if (c == '\'') {
+            get();
+            return makeToken(TokenType::QUOTE);
+        } else if (c == '`') {
+            get();
+            return makeToken(TokenType::QUASIQUOTE);
+        } else if (c == ',') {
+            get();
+            return makeToken(TokenType::UNQUOTE);
         } else if (c == '#') {
-            if (auto result = BooleanLiteralToken::fromChar(input[pos + 1])) {
-                pos += 2;
-                return result;
+            get();
+            auto next = peek();
+            if (next == '(') {
+                get();
+                return makeToken(TokenType::VECTOR_BEGIN);
+            } else if (next == 't' || next == 'f') {
+                get();
+                Token token{TokenType::BOOLEAN_LITERAL};
+                token.boolean = next == 't';
+                return token;
             } else {
                 throw SyntaxError("Unexpected character after #");
             }
         } else if (c == '"') {
-            std::string string;
-            pos++;
-            while (pos < input.size()) {
-                if (input[pos] == '"') {
-                    pos++;
-                    return std::make_unique<StringLiteralToken>(string);
-                } else if (input[pos] == '\\') {
-                    if (pos + 1 >= input.size()) {
-                        throw SyntaxError("Unexpected end of string literal");
-                    }
-                    auto next = input[pos + 1];
-                    if (next == 'n') {
-                        string += '\n';
-                    } else {
-                        string += next;
-                    }
-                    pos += 2;
-                } else {
-                    string += input[pos];
-                    pos++;
-                }
-            }
-            throw SyntaxError("Unexpected end of string literal");
+            get();
+            return readString();
         } else {
-            int start = pos;
-            do {
-                pos++;
-            } while (pos < input.size() && !std::isspace(input[pos]) &&
-                     !TOKEN_END.contains(input[pos]));
-            auto text = input.substr(start, pos - start);
-            if (text == ".") {
-                return Token::dot();
-            }
-            if (std::isdigit(text[0]) || text[0] == '+' || text[0] == '-' || text[0] == '.') {
-                try {
-                    return std::make_unique<NumericLiteralToken>(std::stod(text));
-                } catch (std::invalid_argument& e) {
-                }
-            }
-            return std::make_unique<IdentifierToken>(text);
+            return readAtom();
         }
     }
-    return nullptr;
+    return makeToken(TokenType::END);
 }
 
-std::deque<TokenPtr> Tokenizer::tokenize() {
-    std::deque<TokenPtr> tokens;
-    int pos = 0;
-    while (true) {
-        auto token = nextToken(pos);
-        if (!token) {
-            break;
+Token Tokenizer::readString() {
+    buffer.clear();
+    int c;
+    while ((c = get()) != EOF) {
+        if (c == '"') {
+            return Token{TokenType::STRING_LITERAL, buffer};
+        } else if (c == '\\') {
+            auto next = get();
+            if (next == EOF) {
+                throw SyntaxError("Unexpected end of string literal");
+            }
+            if (next == 'n') {
+                buffer += '\n';
+            } else {
+                buffer += static_cast<char>(next);
+            }
+        } else {
+            buffer += static_cast<char>(c);
         }
-        tokens.push_back(std::move(token));
     }
-    return tokens;
+    throw SyntaxError("Unexpected end of string literal");
 }
 
-std::deque<TokenPtr> Tokenizer::tokenize(const std::string& input) {
-    return Tokenizer(input).tokenize();
+Token Tokenizer::readAtom() {
+    buffer.clear();
+    do {
+        buffer += static_cast<char>(get());
+    } while (!isDelimiter(peek()) && peek() != EOF);
+    if (buffer == ".") {
+        return makeToken(TokenType::DOT);
+    }
+    Token token{TokenType::IDENTIFIER, buffer};
+    auto first = buffer[0];
+    if (!std::isdigit(first) && first != '+' && first != '-' && first != '.') {
+        return token;
+    }
+    // 只由数字（可带一个正负号）组成的是精确整数，由语法分析器按原文
+    // 解析，这里不必再求它的浮点值
+    std::size_t digits = (first == '+' || first == '-') ? 1 : 0;
+    if (buffer.size() > digits &&
+        buffer.find_first_not_of("0123456789", digits) == std::string::npos) {
+        token.type = TokenType::NUMERIC_LITERAL;
+        token.integer = true;
+        return token;
+    }
+    // from_chars 不接受前导的 '+'，解析失败时不抛异常而是作为标识符
+    auto begin = buffer.data() + (first == '+' ? 1 : 0);
+    auto end = buffer.data() + buffer.size();
+    if (begin == end || *begin == '+' || (*begin == '-' && first == '+')) {
+        return token;
+    }
+    auto [ptr, ec] = std::from_chars(begin, end, token.number);
+    if (ptr != end) {
+        return token;
+    }
+    if (ec == std::errc::result_out_of_range) {
+        token.number = std::strtod(buffer.c_str(), nullptr);
+    } else if (ec != std::errc{}) {
+        return token;
+    }
+    token.type = TokenType::NUMERIC_LITERAL;
+    return token;
 }
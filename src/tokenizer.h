@@ -1,21 +1,27 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
-#include <deque>
+#include <istream>
 #include <string>
 
 #include "./token.h"
 
+// 按需从输入流中逐个读出词法标记，不预先读入整个输入
 class Tokenizer {
 private:
-    TokenPtr nextToken(int& pos);
-    std::deque<TokenPtr> tokenize();
+    std::streambuf* input;
+    std::string buffer;  // 当前标记的原文，返回的标记指向这里
 
-    std::string input;
-    Tokenizer(const std::string& input) : input{input} {}
+    int peek();
+    int get();
+    Token readString();
+    Token readAtom();
 
 public:
-    static std::deque<TokenPtr> tokenize(const std::string& input);
+    explicit Tokenizer(std::istream& input) : input{input.rdbuf()} {}
+
+    // 读出下一个词法标记，输入结束时返回 END 类型的标记
+    Token next();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,146 +1,162 @@
 #include "value.h"
 
-#include <iomanip>
-#include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 
+#include "error.h"
 #include "eval_env.h"
+#include "gc.h"
+#include "node.h"
+#include "pool.h"
+#include "printer.h"
+#include "vm.h"
 
 std::vector<std::shared_ptr<Value>> Value::toVector() {
     std::vector<ValuePtr> result;
-    auto pairValue = dynamic_cast<PairValue*>(this);
-    if (pairValue == nullptr) {
+    auto it = elements().begin();
+    for (; it != std::default_sentinel; ++it) {
+        result.push_back(*it);
+    }
+    if (!it.position()->isNil()) {
         throw std::runtime_error(
             "RuntimeError: Value who want to be list is not a PairValue");
     }
-    auto left = pairValue->getLeft();
-    auto right = pairValue->getRight();
-    if (left != nullptr) {
-        result.push_back(left);
-    }
-    if (right != nullptr && (typeid(*right) != typeid(NilValue))) {
-        auto rightVector = right->toVector();
-        result.insert(result.end(), rightVector.begin(), rightVector.end());
-    }
     return result;
 }
 
-std::optional<std::string> Value::asSymbol() {
-    auto symbolValue = dynamic_cast<SymbolValue*>(this);
-    if (symbolValue == nullptr) {
-        return std::nullopt;
-    }
-    return symbolValue->toString();
-}
-
-bool Value::isNil() {
-    return dynamic_cast<NilValue*>(this) != nullptr;
-}
-
-bool Value::isSelfEvaluating() {
-    return dynamic_cast<BooleanValue*>(this) != nullptr ||
-           dynamic_cast<NumericValue*>(this) != nullptr ||
-           dynamic_cast<StringValue*>(this) != nullptr;
-}
-
-bool Value::isNumber() {
-    return dynamic_cast<NumericValue*>(this) != nullptr;
-}
-
-bool Value::isProcedure() const {
-    return false;
-}
-
-bool Value::isPair() {
-    return dynamic_cast<PairValue*>(this) != nullptr;
-}
-
-bool Value::isSymbol() {
-    return dynamic_cast<SymbolValue*>(this) != nullptr;
-}
-
-bool Value::isBoolean() {
-    return dynamic_cast<BooleanValue*>(this) != nullptr;
+std::string Value::toString() const {
+    std::string result;
+    printValue(result, *this);
+    return result;
 }
 
-bool Value::isString() {
-    return dynamic_cast<StringValue*>(this) != nullptr;
+Symbol Value::asSymbol() {
+    return isSymbol() ? static_cast<SymbolValue*>(this) : nullptr;
 }
 
 double Value::asNumber() {
-    auto numericValue = dynamic_cast<NumericValue*>(this);
-    if (numericValue == nullptr) {
-        throw std::runtime_error("RuntimeError: Value is not a NumericValue");
+    switch (type) {
+        case ValueType::INTEGER:
+            return static_cast<double>(
+                static_cast<IntegerValue*>(this)->getValue());
+        case ValueType::BIGINT:
+            return static_cast<BigIntValue*>(this)->getValue().toDouble();
+        case ValueType::NUMERIC:
+            return static_cast<NumericValue*>(this)->getValue();
+        default:
+            throw std::runtime_error(
+                "RuntimeError: Value is not a NumericValue");
     }
-    return numericValue->getValue();
 }
 
 bool Value::asBoolean() {
-    auto booleanValue = dynamic_cast<BooleanValue*>(this);
-    if (booleanValue == nullptr) {
+    if (!isBoolean()) {
         throw std::runtime_error("RuntimeError: Value is not a BooleanValue");
     }
-    return booleanValue->getValue();
+    return static_cast<BooleanValue*>(this)->getValue();
 }
 
-std::string BooleanValue::toString() const {
-    return value ? "#t" : "#f";
+const ValuePtr& BooleanValue::of(bool value) {
+    static const ValuePtr TRUE_VALUE = std::make_shared<BooleanValue>(true);
+    static const ValuePtr FALSE_VALUE = std::make_shared<BooleanValue>(false);
+    return value ? TRUE_VALUE : FALSE_VALUE;
 }
 
 bool BooleanValue::getValue() const {
     return value;
 }
 
-std::string NumericValue::toString() const {
-    std::ostringstream oss;
-    if (value == static_cast<int>(value)) {
-        oss << static_cast<int>(value);
-    } else {
-        oss << value;
+ValuePtr IntegerValue::of(std::int64_t value) {
+    constexpr std::int64_t CACHE_MIN = -128;
+    constexpr std::int64_t CACHE_MAX = 1023;
+    static const std::vector<ValuePtr> cache = [] {
+        std::vector<ValuePtr> result;
+        for (auto i = CACHE_MIN; i <= CACHE_MAX; ++i) {
+            result.push_back(std::make_shared<IntegerValue>(i));
+        }
+        return result;
+    }();
+    if (value >= CACHE_MIN && value <= CACHE_MAX) {
+        return cache[value - CACHE_MIN];
     }
-    return oss.str();
+    return makePooled<IntegerValue>(value);
 }
 
-double NumericValue::getValue() const {
-    return value;
+ValuePtr NumericValue::of(double value) {
+    return makePooled<NumericValue>(value);
 }
 
-std::string StringValue::toString() const {
-    std::ostringstream oss;
-    oss << std::quoted(value);
-    return oss.str();
+double NumericValue::getValue() const {
+    return value;
 }
 
-std::string StringValue::getValue() const {
+const std::string& StringValue::getValue() const {
     return value;
 }
 
-std::string NilValue::toString() const {
-    return "()";
+const ValuePtr& NilValue::instance() {
+    static const ValuePtr NIL = std::make_shared<NilValue>();
+    return NIL;
 }
 
-std::string SymbolValue::toString() const {
-    return value;
-}
-
-std::string PairValue::toStringPure() const {
-    std::ostringstream oss;
-    oss << left->toString();
-    if (typeid(*right) == typeid(PairValue)) {
-        auto& pair = static_cast<const PairValue&>(*right);
-        if (typeid(*pair.getRight()) == typeid(NilValue)) {
-            oss << " " << pair.getLeft()->toString();
-        } else {
-            oss << " " << pair.toStringPure();
+// 允许直接用 string_view 查找，已驻留的符号不必构造临时字符串
+struct SymbolNameHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+std::shared_ptr<SymbolValue> SymbolValue::intern(std::string_view name) {
+    static std::unordered_map<std::string, std::shared_ptr<SymbolValue>,
+                              SymbolNameHash, std::equal_to<>>
+        table;
+    auto it = table.find(name);
+    if (it != table.end()) {
+        return it->second;
+    }
+    auto id = static_cast<std::uint32_t>(table.size());
+    std::shared_ptr<SymbolValue> symbol(new SymbolValue(name, id));
+    table.emplace(name, symbol);
+    return symbol;
+}
+
+// 只被这里引用的容器：析构时会连带析构它的子节点
+static bool releasable(const ValuePtr& value) {
+    return value && value.use_count() == 1 &&
+           (value->isPair() || value->getType() == ValueType::VECTOR);
+}
+
+void releaseContainers(ValuePtr next, std::vector<ValuePtr>& pending) {
+    while (true) {
+        while (next) {
+            // 先摘下独占的子容器，next 本身析构时就不会再递归
+            ValuePtr rest;
+            if (next->isPair()) {
+                auto& pair = static_cast<PairValue&>(*next);
+                if (releasable(pair.left)) {
+                    pending.push_back(std::move(pair.left));
+                }
+                if (releasable(pair.right)) rest = std::move(pair.right);
+            } else {
+                for (auto& value : static_cast<VectorValue&>(*next).values) {
+                    if (releasable(value)) pending.push_back(std::move(value));
+                }
+            }
+            next = std::move(rest);
         }
-    } else if (typeid(*right) != typeid(NilValue)) {
-        oss << " . " << right->toString();
+        if (pending.empty()) break;
+        next = std::move(pending.back());
+        pending.pop_back();
     }
-    return oss.str();
 }
 
-std::string PairValue::toString() const {
-    return "(" + toStringPure() + ")";
+PairValue::~PairValue() {
+    std::vector<ValuePtr> pending;
+    if (releasable(left)) pending.push_back(std::move(left));
+    ValuePtr next;
+    if (releasable(right)) next = std::move(right);
+    releaseContainers(std::move(next), pending);
 }
 
 void PairValue::setRight(std::shared_ptr<Value> value) {
@@ -150,52 +166,75 @@ void PairValue::setLeft(std::shared_ptr<Value> value) {
     left = value;
 }
 
-ValuePtr ListValue::operator[](size_t index) const {
-    if (index >= values.size() || index < 0) {
-        throw std::out_of_range("The Index of ListValue out of range");
-    }
-    return values[index];
+ContainerValue::ContainerValue(ValueType type) : Value(type) {
+    CycleCollector::track(this);
 }
 
-std::string ListValue::toString() const {
-    std::string result = "(";
-    for (const auto& value : values) {
-        result += value->toString() + " ";
-    }
-    result += ")";
-    return result;
+ContainerValue::~ContainerValue() {
+    CycleCollector::untrack(this);
 }
 
-void ListValue::append(ValuePtr value) {
-    values.push_back(value);
+VectorValue::~VectorValue() {
+    std::vector<ValuePtr> pending;
+    for (auto& value : values) {
+        if (releasable(value)) pending.push_back(std::move(value));
+    }
+    releaseContainers(nullptr, pending);
 }
 
-std::string BuiltinProcValue::toString() const {
-    return "#procedure";
+ListBuilder::ListBuilder() : head(NilValue::instance()) {}
+
+void ListBuilder::push(ValuePtr value) {
+    auto cell = makePooled<PairValue>(std::move(value), NilValue::instance());
+    auto next = cell.get();
+    if (last) {
+        last->setRight(std::move(cell));
+    } else {
+        head = std::move(cell);
+    }
+    last = next;
 }
 
-bool BuiltinProcValue::isProcedure() const {
-    return true;
+ValuePtr ListBuilder::build(ValuePtr tail) {
+    if (!last) return tail;
+    last->setRight(std::move(tail));
+    return std::move(head);
 }
 
 BuiltinFuncType* BuiltinProcValue::getFunc() const {
     return func;
 }
 
-std::string LambdaValue::toString() const {
-    return "#procedure";
-}
-
-bool LambdaValue::isProcedure() const {
-    return true;
+void BuiltinProcValue::arityError(std::size_t count) const {
+    std::string expected = std::to_string(minArgs);
+    if (maxArgs == VARIADIC) {
+        expected = "at least " + expected;
+    } else if (maxArgs != minArgs) {
+        expected += " to " + std::to_string(maxArgs);
+    }
+    throw LispError(std::string(name) + " expects " + expected +
+                    " argument(s), got " + std::to_string(count) + ".");
 }
 
-ValuePtr LambdaValue::apply(const std::vector<ValuePtr>& args) {
-    auto lambdaEnv =
-        definingEnv->createChild(params, args);  // 创建新的求值环境
-    ValuePtr lastEvalResult = std::make_shared<NilValue>();  // 默认返回值
-    for (auto& expr : body) {
-        lastEvalResult = lambdaEnv->eval(expr);  // 在新环境中求值每个表达式
+ValuePtr LambdaValue::apply(std::span<const ValuePtr> args) {
+    if (compiled) {
+        return VM::call(*this, args);
+    }
+    auto lambdaEnv = code->bind(*definingEnv, args);  // 创建新的求值环境
+    const LambdaNode* current = code.get();
+    TailCall call;
+    std::shared_ptr<LambdaValue> callee;  // 保证尾调用的目标在循环中存活
+    while (true) {
+        // 每进入一个新帧都是回收的安全点，长时间的计算中途也能回收
+        CycleCollector::maybeCollect();
+        ValuePtr result =
+            evalSequenceTail(current->getBody(), *lambdaEnv, call);
+        if (result) {
+            return result;  // 返回最后一个表达式的求值结果
+        }
+        // 尾调用：在同一层 C++ 栈上换成被调过程的新帧继续执行
+        callee = std::move(call.proc);
+        lambdaEnv = callee->code->bind(*callee->definingEnv, call.args);
+        current = callee->code.get();
     }
-    return lastEvalResult;  // 返回最后一个表达式的求值结果
 }
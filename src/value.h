@@ -1,52 +1,149 @@
 #ifndef VALUE_H
 #define VALUE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "bigint.h"
+
 class EvalEnv;
+class LambdaNode;
+class SymbolValue;
+class ListRange;
+using Symbol = const SymbolValue*;  // 驻留后的符号，相同名字总是同一个对象
+
+// 值的具体类型，由各子类构造时写入，类型判断只需比较这个标记
+enum class ValueType : std::uint8_t {
+    BOOLEAN,
+    INTEGER,  // int64 范围内的精确整数
+    BIGINT,   // 超出 int64 的精确整数
+    NUMERIC,  // 浮点数
+    STRING,
+    NIL,
+    SYMBOL,
+    PAIR,
+    BUILTIN,
+    LAMBDA,
+    HASH_TABLE,
+    VECTOR,
+    OUTPUT_PORT,
+};
+
 class Value {
+    const ValueType type;
+
+protected:
+    explicit Value(ValueType type) : type(type) {}
+
 public:
     virtual ~Value() = default;
-    virtual std::string toString() const = 0;
-    virtual bool isProcedure() const;
-    bool isNil();
-    bool isSelfEvaluating();
-    bool isNumber();
-    bool isPair();
-    virtual bool isSymbol();
-    virtual bool isBoolean();
-    virtual bool isString();
+    // 外部表示，由 printer.h 中的 printValue 生成
+    std::string toString() const;
+    ValueType getType() const {
+        return type;
+    }
+    bool isProcedure() const {
+        return type == ValueType::BUILTIN || type == ValueType::LAMBDA;
+    }
+    bool isNil() const {
+        return type == ValueType::NIL;
+    }
+    bool isSelfEvaluating() const {
+        return type == ValueType::BOOLEAN || isNumber() ||
+               type == ValueType::STRING || type == ValueType::VECTOR;
+    }
+    bool isNumber() const {
+        return isExact() || type == ValueType::NUMERIC;
+    }
+    bool isExact() const {
+        return type == ValueType::INTEGER || type == ValueType::BIGINT;
+    }
+    bool isPair() const {
+        return type == ValueType::PAIR;
+    }
+    bool isSymbol() const {
+        return type == ValueType::SYMBOL;
+    }
+    bool isBoolean() const {
+        return type == ValueType::BOOLEAN;
+    }
+    bool isString() const {
+        return type == ValueType::STRING;
+    }
+    bool isTrue() const;  // 除 #f 以外的值都为真
     double asNumber();
     bool asBoolean();
+    // 把正规列表的元素复制到向量中，空表得到空向量
     std::vector<std::shared_ptr<Value>> toVector();
-    std::optional<std::string> asSymbol();
+    // 不复制地遍历序对链上的各个元素
+    ListRange elements() const;
+    Symbol asSymbol();
 };
 
 using ValuePtr =
     std::shared_ptr<Value>;  // 把这个添加到 value.h，可以减少许多重复的代码。
 
-using BuiltinFuncType = ValuePtr(const std::vector<ValuePtr>&, EvalEnv& env);
+// 内置过程直接读取调用方持有的实参，不复制也不分配
+using BuiltinFuncType = ValuePtr(std::span<const ValuePtr>, EvalEnv& env);
+// 内置过程的实参个数没有上限
+inline constexpr std::size_t VARIADIC = SIZE_MAX;
 
 class BooleanValue : public Value {
     bool value;
 
 public:
-    BooleanValue(bool value) : value(value) {}
+    BooleanValue(bool value) : Value(ValueType::BOOLEAN), value(value) {}
+    // #t 与 #f 各只有一个共享实例
+    static const ValuePtr& of(bool value);
     bool getValue() const;
-    std::string toString() const override;
     ~BooleanValue() override = default;
 };
 
+inline bool Value::isTrue() const {
+    return type != ValueType::BOOLEAN ||
+           static_cast<const BooleanValue*>(this)->getValue();
+}
+
+class IntegerValue : public Value {
+    std::int64_t value;
+
+public:
+    IntegerValue(std::int64_t value)
+        : Value(ValueType::INTEGER), value(value) {}
+    // 小整数取自预先分配的缓存，其余才新建对象
+    static ValuePtr of(std::int64_t value);
+    std::int64_t getValue() const {
+        return value;
+    }
+    ~IntegerValue() override = default;
+};
+
+class BigIntValue : public Value {
+    BigInt value;
+
+public:
+    BigIntValue(BigInt value)
+        : Value(ValueType::BIGINT), value(std::move(value)) {}
+    const BigInt& getValue() const {
+        return value;
+    }
+    ~BigIntValue() override = default;
+};
+
 class NumericValue : public Value {
     double value;
 
 public:
-    NumericValue(double value) : value(value) {}
-    std::string toString() const override;
+    NumericValue(double value) : Value(ValueType::NUMERIC), value(value) {}
+    static ValuePtr of(double value);
     double getValue() const;
     ~NumericValue() override = default;
 };
@@ -55,85 +152,219 @@ class StringValue : public Value {
     std::string value;
 
 public:
-    StringValue(const std::string& value) : value(value) {}
-    std::string toString() const override;
-    std::string getValue() const;
+    StringValue(std::string value)
+        : Value(ValueType::STRING), value(std::move(value)) {}
+    const std::string& getValue() const;
     ~StringValue() override = default;
 };
 
 class NilValue : public Value {
 public:
-    std::string toString() const override;
+    NilValue() : Value(ValueType::NIL) {}
+    static const ValuePtr& instance();  // 空表只有一个共享实例
     ~NilValue() override = default;
 };
 
 class SymbolValue : public Value {
 private:
     std::string value;
+    std::uint32_t id;
+
+    SymbolValue(std::string_view name, std::uint32_t id)
+        : Value(ValueType::SYMBOL), value(name), id(id) {}
 
 public:
-    SymbolValue(const std::string& name) : value(name) {}
-    std::string toString() const override;
+    // 从全局驻留表中取出名为 name 的符号，不存在时创建
+    static std::shared_ptr<SymbolValue> intern(std::string_view name);
+    const std::string& getName() const {
+        return value;
+    }
+    std::uint32_t getId() const {
+        return id;
+    }
     ~SymbolValue() override = default;
 };
 
+// 释放序对与向量。从 next 出发沿 cdr 链循环，只被这里引用的其它子序对、
+// 子向量暂存在 pending 中稍后处理，长列表和深层嵌套（包括序对与向量
+// 交错嵌套）都不会递归析构耗尽栈
+void releaseContainers(ValuePtr next, std::vector<ValuePtr>& pending);
+
 class PairValue : public Value {
     std::shared_ptr<Value> left;
     std::shared_ptr<Value> right;
 
+    friend void releaseContainers(ValuePtr, std::vector<ValuePtr>&);
+
 public:
     PairValue(std::shared_ptr<Value> left, std::shared_ptr<Value> right)
-        : left(left), right(right) {}
-    ~PairValue() override = default;
+        : Value(ValueType::PAIR), left(left), right(right) {}
+    ~PairValue() override;
     void setRight(std::shared_ptr<Value> value);void setLeft(std::shared_ptr<Value> value);
-    std::shared_ptr<Value> getLeft() const {
+    const std::shared_ptr<Value>& getLeft() const {
         return left;
     }
-    std::shared_ptr<Value> getRight() const {
+    const std::shared_ptr<Value>& getRight() const {
         return right;
     }
-    std::string toStringPure() const;
-    std::string toString() const override;
 };
 
-class ListValue : public Value {
-    std::vector<ValuePtr> values;
+// 沿序对链逐个访问元素的迭代器，遇到第一个不是序对的 cdr 时结束，
+// 此时 position() 就是这个 cdr（正规列表为空表）
+class ListIterator {
+    const Value* current;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ValuePtr;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ValuePtr*;
+    using reference = const ValuePtr&;
+
+    explicit ListIterator(const Value* current) : current(current) {}
+    reference operator*() const {
+        return static_cast<const PairValue*>(current)->getLeft();
+    }
+    pointer operator->() const {
+        return &**this;
+    }
+    ListIterator& operator++() {
+        current = static_cast<const PairValue*>(current)->getRight().get();
+        return *this;
+    }
+    ListIterator operator++(int) {
+        auto old = *this;
+        ++*this;
+        return old;
+    }
+    bool operator==(std::default_sentinel_t) const {
+        return !current->isPair();
+    }
+    const Value* position() const {
+        return current;
+    }
+};
+
+class ListRange {
+    const Value* head;
+
+public:
+    explicit ListRange(const Value* head) : head(head) {}
+    ListIterator begin() const {
+        return ListIterator(head);
+    }
+    std::default_sentinel_t end() const {
+        return {};
+    }
+};
+
+inline ListRange Value::elements() const {
+    return ListRange(this);
+}
+
+// 从前往后逐个追加元素来构造列表
+class ListBuilder {
+    ValuePtr head;
+    PairValue* last = nullptr;
+
+public:
+    ListBuilder();
+    void push(ValuePtr value);
+    ValuePtr build() {
+        return std::move(head);
+    }
+    // 以 tail 作为最后一个序对的 cdr，用于构造非正规列表
+    ValuePtr build(ValuePtr tail);
+};
+
+// 可以修改、因而能引用自身的容器（向量与散列表）。存活期间登记在
+// CycleCollector 中，只由彼此构成的环也能被直接找到
+class ContainerValue : public Value,
+                       public std::enable_shared_from_this<ContainerValue> {
+    friend class CycleCollector;
+
+    ContainerValue* prevTracked = nullptr;  // CycleCollector 中的前后容器
+    ContainerValue* nextTracked = nullptr;
+
+protected:
+    explicit ContainerValue(ValueType type);
 
 public:
-    ListValue(const std::vector<ValuePtr>& values) : values(values) {}
-    ~ListValue() override = default;
+    ~ContainerValue() override;
+    ContainerValue(const ContainerValue&) = delete;
+    ContainerValue& operator=(const ContainerValue&) = delete;
+};
 
-    void append(ValuePtr value);
-    ValuePtr operator[](size_t index) const;
-    std::string toString() const override;
+// 连续存放元素的向量，按下标 O(1) 访问
+class VectorValue : public ContainerValue {
+    std::vector<ValuePtr> values;
+
+    friend void releaseContainers(ValuePtr, std::vector<ValuePtr>&);
+
+public:
+    VectorValue(std::vector<ValuePtr> values)
+        : ContainerValue(ValueType::VECTOR), values(std::move(values)) {}
+    ~VectorValue() override;
+    std::vector<ValuePtr>& getValues() {
+        return values;
+    }
+    const std::vector<ValuePtr>& getValues() const {
+        return values;
+    }
 };
 
 class BuiltinProcValue : public Value {
+    std::string_view name;
     BuiltinFuncType* func;
+    std::size_t minArgs;
+    std::size_t maxArgs;
+
+    [[noreturn]] void arityError(std::size_t count) const;
 
 public:
-    BuiltinProcValue(BuiltinFuncType* func) : func(func) {}
+    BuiltinProcValue(std::string_view name, BuiltinFuncType* func,
+                     std::size_t minArgs, std::size_t maxArgs)
+        : Value(ValueType::BUILTIN),
+          name(name),
+          func(func),
+          minArgs(minArgs),
+          maxArgs(maxArgs) {}
     ~BuiltinProcValue() override = default;
-    std::string toString() const override;
-    bool isProcedure() const override;
     BuiltinFuncType* getFunc() const;
+    // 检查实参个数后调用，各内置过程不必再自己检查
+    ValuePtr call(std::span<const ValuePtr> args, EvalEnv& env) const {
+        if (args.size() < minArgs || args.size() > maxArgs) {
+            arityError(args.size());
+        }
+        return func(args, env);
+    }
 };
 
-
 class LambdaValue : public Value {
-    std::vector<std::string> params;
-    std::vector<ValuePtr> body;
+    friend class ImageReader;
+
+    std::shared_ptr<const LambdaNode> code;  // 参数表与已分析的函数体
     std::shared_ptr<EvalEnv> definingEnv;
+    bool compiled;  // 由虚拟机创建的闭包，调用时执行字节码
 
 public:
-    LambdaValue(const std::vector<std::string>& params,
-                const std::vector<ValuePtr>& body,
-                std::shared_ptr<EvalEnv> definingEnv)
-        : params(params), body(body), definingEnv(definingEnv) {}
+    LambdaValue(std::shared_ptr<const LambdaNode> code,
+                std::shared_ptr<EvalEnv> definingEnv, bool compiled = false)
+        : Value(ValueType::LAMBDA),
+          code(std::move(code)),
+          definingEnv(std::move(definingEnv)),
+          compiled(compiled) {}
     ~LambdaValue() override = default;
-    std::string toString() const override;
-    ValuePtr apply(const std::vector<ValuePtr>& args);
-    bool isProcedure() const override;
+    ValuePtr apply(std::span<const ValuePtr> args);
+    const std::shared_ptr<const LambdaNode>& getCode() const {
+        return code;
+    }
+    const std::shared_ptr<EvalEnv>& getEnv() const {
+        return definingEnv;
+    }
+    bool isCompiled() const {
+        return compiled;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "vm.h"
+
+#include "error.h"
+#include "eval_env.h"
+#include "gc.h"
+#include "node.h"
+#include "pool.h"
+
+ValuePtr VM::execute(CodePtr code, std::shared_ptr<EvalEnv> env) {
+    VM vm;
+    return vm.run(std::move(code), std::move(env));
+}
+
+ValuePtr VM::call(const LambdaValue& lambda, std::span<const ValuePtr> args) {
+    auto& code = lambda.getCode();
+    auto env = code->bind(*lambda.getEnv(), args);
+    return execute(code->getCompiled(), std::move(env));
+}
+
+static bool isFalse(const ValuePtr& value) {
+    return !value->isTrue();
+}
+
+ValuePtr VM::run(CodePtr code, std::shared_ptr<EvalEnv> env) {
+    stack.reserve(64);
+    std::size_t pc = 0;
+    // 弹出当前帧；若已回到最外层则返回 true
+    auto popFrame = [&]() {
+        if (frames.empty()) return true;
+        auto& frame = frames.back();
+        code = std::move(frame.code);
+        pc = frame.pc;
+        env = std::move(frame.env);
+        frames.pop_back();
+        return false;
+    };
+    while (true) {
+        Instruction ins = code->instructions[pc++];
+        switch (ins.op) {
+            case OpCode::CONST:
+                stack.push_back(code->constants[ins.operand]);
+                break;
+            case OpCode::LOAD_GLOBAL:
+                stack.push_back(env->getGlobal().lookupGlobal(
+                    code->names[ins.operand], code->caches[ins.operand]));
+                break;
+            case OpCode::LOAD_LOCAL: {
+                auto& value = env->ancestor(ins.aux).slots[ins.operand];
+                if (!value) {
+                    auto name = code->localNames.at(pc - 1);
+                    throw LispError("Variable " + name->getName() +
+                                    " not defined.");
+                }
+                stack.push_back(value);
+                break;
+            }
+            case OpCode::DEFINE_GLOBAL:
+                env->getGlobal().defineGlobal(code->names[ins.operand],
+                                              std::move(stack.back()));
+                stack.back() = NilValue::instance();
+                break;
+            case OpCode::DEFINE_LOCAL:
+                env->slots[ins.operand] = std::move(stack.back());
+                stack.back() = NilValue::instance();
+                break;
+            case OpCode::POP: stack.pop_back(); break;
+            case OpCode::JUMP: pc = ins.operand; break;
+            case OpCode::JUMP_IF_FALSE: {
+                bool jump = isFalse(stack.back());
+                stack.pop_back();
+                if (jump) pc = ins.operand;
+                break;
+            }
+            case OpCode::JUMP_IF_FALSE_KEEP:
+                if (isFalse(stack.back())) {
+                    pc = ins.operand;
+                } else {
+                    stack.pop_back();
+                }
+                break;
+            case OpCode::JUMP_IF_TRUE_KEEP:
+                if (!isFalse(stack.back())) {
+                    pc = ins.operand;
+                } else {
+                    stack.pop_back();
+                }
+                break;
+            case OpCode::CALL:
+            case OpCode::TAIL_CALL: {
+                auto procIt = stack.end() - ins.operand - 1;
+                std::span<const ValuePtr> callArgs(
+                    stack.data() + (procIt - stack.begin()) + 1, ins.operand);
+                ValuePtr proc = *procIt;
+                auto lambda = proc->getType() == ValueType::LAMBDA
+                                  ? static_cast<LambdaValue*>(proc.get())
+                                  : nullptr;
+                if (lambda && lambda->isCompiled()) {
+                    auto& lambdaCode = lambda->getCode();
+                    auto lambdaEnv =
+                        lambdaCode->bind(*lambda->getEnv(), callArgs);
+                    stack.erase(procIt, stack.end());
+                    if (ins.op == OpCode::CALL) {
+                        frames.push_back(
+                            {std::move(code), pc, std::move(env)});
+                    }
+                    code = lambdaCode->getCompiled();
+                    pc = 0;
+                    env = std::move(lambdaEnv);
+                    // 进入新帧是回收的安全点：帧栈与操作数栈上的值都是根
+                    CycleCollector::maybeCollect();
+                    break;
+                }
+                // 实参直接从操作数栈上借给被调过程。它们若再进入虚拟机，
+                // 用的是新的 VM 实例，不会改动这里的栈
+                ValuePtr result;
+                if (proc->getType() == ValueType::BUILTIN) {
+                    auto builtin = static_cast<BuiltinProcValue*>(proc.get());
+                    result = builtin->call(callArgs, *env);
+                } else if (lambda) {
+                    result = lambda->apply(callArgs);
+                } else {
+                    throw LispError("Unimplemented");
+                }
+                stack.erase(procIt, stack.end());
+                stack.push_back(std::move(result));
+                if (ins.op == OpCode::TAIL_CALL && popFrame()) {
+                    ValuePtr result = std::move(stack.back());
+                    stack.pop_back();
+                    return result;
+                }
+                break;
+            }
+            case OpCode::RETURN:
+                if (popFrame()) {
+                    ValuePtr result = std::move(stack.back());
+                    stack.pop_back();
+                    return result;
+                }
+                break;
+            case OpCode::CLOSURE:
+                stack.push_back(std::make_shared<LambdaValue>(
+                    code->lambdas[ins.operand], env, true));
+                break;
+            case OpCode::ENTER: {
+                auto first = stack.size() - ins.aux;
+                auto letEnv = env->createChild(
+                    ins.operand,
+                    std::span<const ValuePtr>(stack.data() + first, ins.aux));
+                stack.resize(first);
+                env = std::move(letEnv);
+                break;
+            }
+            case OpCode::LEAVE: env = env->getParent(); break;
+            case OpCode::LIST: {
+                ValuePtr result = NilValue::instance();
+                for (std::uint32_t i = 0; i < ins.operand; ++i) {
+                    result = makePooled<PairValue>(
+                        std::move(stack.back()), result);
+                    stack.pop_back();
+                }
+                stack.push_back(std::move(result));
+                break;
+            }
+        }
+    }
+}
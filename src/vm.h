@@ -0,0 +1,31 @@
+#ifndef VM_H
+#define VM_H
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "bytecode.h"
+#include "value.h"
+
+class EvalEnv;
+
+// 基于操作数栈的字节码虚拟机。编译后的闭包之间的调用不占用 C++ 栈
+class VM {
+    struct Frame {
+        CodePtr code;
+        std::size_t pc;
+        std::shared_ptr<EvalEnv> env;
+    };
+    std::vector<ValuePtr> stack;
+    std::vector<Frame> frames;
+
+    ValuePtr run(CodePtr code, std::shared_ptr<EvalEnv> env);
+
+public:
+    static ValuePtr execute(CodePtr code, std::shared_ptr<EvalEnv> env);
+    static ValuePtr call(const LambdaValue& lambda,
+                         std::span<const ValuePtr> args);
+};
+
+#endif
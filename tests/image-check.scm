@@ -0,0 +1,18 @@
+; 映像往返测试的第二步：由 --image 载入映像后检查各个绑定
+(define (check name ok) (if (not ok) (error name)))
+(check "number" (= number 42))
+(check "big" (= big (* 4294967296 4294967296)))
+(check "shared" (eq? (car data) (car (cdr data))))
+(check "shared in vector"
+       (eq? (car data) (vector-ref (car (cdr (cdr data))) 0)))
+(check "global shared" (eq? shared (car data)))
+(check "hash table" (eq? (hash-ref table 'self) table))
+(check "hash key" (equal? (hash-ref table "key") '(1 2)))
+(check "closure" (= (sum-from-100 4) 110))
+(check "procedure" (= ((make-sum 1) 2) 4))
+(check "shared frame" (= ((car pair)) 7))
+(check "shared frame call" (= ((car (cdr pair)) 1) 8))
+(define (depth x n)
+  (if (pair? x) (depth (vector-ref (car x) 0) (+ n 1)) n))
+(check "deep" (= (depth deep 0) 100000))
+(displayln "image ok")
@@ -0,0 +1,16 @@
+; 映像往返测试的第一步：定义各种绑定，由 --dump-image 写出
+(define number 42)
+(define big 18446744073709551616)
+(define shared (list 1 2))
+(define data (list shared shared (vector shared "s") 'x))
+(define table (make-hash-table))
+(hash-set! table 'self table)
+(hash-set! table "key" '(1 2))
+(define (make-sum start)
+  (define (sum n) (if (= n 0) start (+ n (sum (- n 1)))))
+  sum)
+(define sum-from-100 (make-sum 100))
+(define (both x) (list (lambda () x) (lambda (y) (+ x y))))
+(define pair (both 7))
+(define (nest n acc) (if (= n 0) acc (nest (- n 1) (list (vector acc)))))
+(define deep (nest 100000 '()))
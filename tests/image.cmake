@@ -0,0 +1,34 @@
+# 映像往返测试：执行 image-dump.scm 后写出映像，再载入映像执行
+# image-check.scm；随后载入截断或损坏的映像必须报错。
+# 用法：cmake -DMINI_LISP=... -DTESTS=... -DIMAGE=... [-DENGINE=--vm] -P
+execute_process(
+  COMMAND ${MINI_LISP} ${ENGINE} ${TESTS}/image-dump.scm --dump-image ${IMAGE}
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "--dump-image failed: ${result}")
+endif()
+execute_process(
+  COMMAND ${MINI_LISP} ${ENGINE} --image ${IMAGE} ${TESTS}/image-check.scm
+  RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+if(NOT result EQUAL 0 OR NOT output MATCHES "image ok")
+  message(FATAL_ERROR "--image check failed: ${output}${error}")
+endif()
+# 不是映像的文件
+execute_process(
+  COMMAND ${MINI_LISP} ${ENGINE} --image ${TESTS}/load.scm
+          ${TESTS}/image-check.scm
+  RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+if(NOT result EQUAL 1)
+  message(FATAL_ERROR "--image load.scm should fail: ${result}")
+endif()
+# 损坏的映像（包括帧大小或槽位下标越界的代码）必须报告 Corrupt image
+foreach(broken truncated.image corrupt.image bad-frame-size.image
+               bad-slot.image)
+  execute_process(
+    COMMAND ${MINI_LISP} ${ENGINE} --image ${TESTS}/${broken}
+            ${TESTS}/image-check.scm
+    RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+  if(NOT result EQUAL 1 OR NOT "${output}${error}" MATCHES "Corrupt image")
+    message(FATAL_ERROR "--image ${broken} should fail: ${result} ${error}")
+  endif()
+endforeach()
@@ -0,0 +1,4 @@
+; 执行到一半出错的脚本：出错之前的定义已经生效
+(define before-error 1)
+(car '())
+(define after-error 2)
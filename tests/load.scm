@@ -0,0 +1,4 @@
+; load 的测试脚本：定义写入全局环境，返回最后一个表达式的值
+(define loaded-value 42)
+(define (loaded-square x) (* x x))
+(loaded-square 7)